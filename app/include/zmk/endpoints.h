@@ -75,3 +75,23 @@ int zmk_endpoints_send_mouse_report();
 #endif // IS_ENABLE(CONFIG_ZMK_MOUSE)
 
 void zmk_endpoints_clear_current(void);
+
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+struct zmk_endpoints_report_stats {
+    /** Number of reports sent to any endpoint. */
+    uint32_t sent;
+    /** Number of reports skipped because they matched the last report sent to the endpoint. */
+    uint32_t suppressed;
+};
+
+/**
+ * Gets the number of reports sent and skipped since boot.
+ */
+struct zmk_endpoints_report_stats zmk_endpoints_get_report_stats(void);
+
+/**
+ * Forgets the last reports sent to an endpoint instance, so that the next report of each type is
+ * sent even if it matches. Transports call this when they drop a report after accepting it.
+ */
+void zmk_endpoints_invalidate_sent_reports(struct zmk_endpoint_instance endpoint);
+#endif // IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
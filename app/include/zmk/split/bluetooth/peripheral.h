@@ -8,4 +8,20 @@
 
 bool zmk_split_bt_peripheral_is_connected(void);
 
-bool zmk_split_bt_peripheral_is_bonded(void);
\ No newline at end of file
+bool zmk_split_bt_peripheral_is_bonded(void);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+struct zmk_split_bt_peripheral_position_events_stats {
+    // Key position events sent to the central.
+    uint32_t events;
+    // Notifications the key position events were sent in, not counting full position states.
+    uint32_t notifications;
+    // Sum of the time each key position event waited before being sent, in microseconds.
+    uint64_t total_delay_us;
+};
+
+void zmk_split_bt_peripheral_get_position_events_stats(
+    struct zmk_split_bt_peripheral_position_events_stats *stats);
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
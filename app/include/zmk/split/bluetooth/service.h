@@ -6,7 +6,10 @@
 
 #pragma once
 
+#include <zephyr/sys/util.h>
+
 #include <zmk/events/sensor_event.h>
+#include <zmk/matrix.h>
 #include <zmk/sensors.h>
 
 #define ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN 9
@@ -18,6 +21,8 @@ struct sensor_event {
     struct zmk_sensor_channel_data channel_data[ZMK_SENSOR_EVENT_MAX_CHANNELS];
 } __packed;
 
+// Written to the RUN_BEHAVIOR characteristic. The layout is shared with earlier versions, so key
+// positions above UINT8_MAX can only be sent with RUN_BEHAVIOR_BATCH.
 struct zmk_split_run_behavior_data {
     uint8_t position;
     uint8_t state;
@@ -30,8 +35,50 @@ struct zmk_split_run_behavior_payload {
     char behavior_dev[ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN];
 } __packed;
 
-int zmk_split_bt_position_pressed(uint8_t position);
-int zmk_split_bt_position_released(uint8_t position);
-int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
-                                  const struct zmk_sensor_channel_data channel_data[],
-                                  size_t channel_data_size);
+// Batched run behavior writes carry a header followed by behavior invocations, numbered
+// consecutively starting at `seq`. Behaviors are identified by their local ID. Once a write is
+// handled, the peripheral notifies the sequence number it expects next, acknowledging every
+// invocation before it.
+struct zmk_split_run_behavior_batch_header {
+    uint8_t seq;
+} __packed;
+
+struct zmk_split_run_behavior_batch_item {
+    uint16_t local_id;
+    uint16_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+} __packed;
+
+// Key position state is a bitmap of all keymap positions, but never shorter than the 16 bytes
+// earlier versions always sent, so they can still parse it.
+#define ZMK_SPLIT_POS_STATE_LEN MAX(16, DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8))
+
+// Position event notifications carry a header followed by either a part of the position state
+// bitmap (when ZMK_SPLIT_POSITION_EVENTS_FLAG_FULL_STATE is set) or a list of position events.
+// `timestamp` holds the lower 32 bits of the peripheral uptime in milliseconds when the
+// notification was sent, which the central uses to keep track of the peripheral clock.
+#define ZMK_SPLIT_POSITION_EVENTS_FLAG_FULL_STATE BIT(0)
+
+struct zmk_split_position_events_header {
+    uint8_t flags;
+    uint8_t seq;
+    uint32_t timestamp;
+} __packed;
+
+// Bitmaps that don't fit the ATT MTU are sent in several chunks, each starting at `offset` bytes.
+struct zmk_split_position_state_chunk {
+    uint16_t offset;
+    uint8_t data[];
+} __packed;
+
+// The upper bit of `state_age` is the new position state, the lower bits the number of
+// milliseconds between the position change and the notification timestamp.
+#define ZMK_SPLIT_POSITION_EVENT_PRESSED BIT(15)
+#define ZMK_SPLIT_POSITION_EVENT_AGE_MASK 0x7FFF
+
+struct zmk_split_position_event {
+    uint16_t position;
+    uint16_t state_age;
+} __packed;
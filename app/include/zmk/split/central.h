@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zmk/behavior.h>
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#include <zmk/hid_indicators_types.h>
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+#define ZMK_SPLIT_IS_CENTRAL                                                                       \
+    (IS_ENABLED(CONFIG_ZMK_SPLIT) && IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
+
+#if ZMK_SPLIT_IS_CENTRAL
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE)
+#define ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT CONFIG_ZMK_SPLIT_BLE_CENTRAL_PERIPHERALS
+#elif IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED) || IS_ENABLED(CONFIG_ZMK_SPLIT_LOOPBACK)
+#define ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT 1
+#endif
+
+#endif // ZMK_SPLIT_IS_CENTRAL
+
+int zmk_split_central_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                                      struct zmk_behavior_binding_event event, bool state);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_central_update_hid_indicator(zmk_hid_indicators_t indicators);
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+struct zmk_split_central_peripheral_stats {
+    // Most key position events waiting to be raised at once.
+    uint32_t queue_high_water_mark;
+    // Key position events that didn't fit the queue.
+    uint32_t dropped_events;
+    // Times the key positions were resynced from the peripheral state after dropping events.
+    uint32_t resyncs;
+};
+
+int zmk_split_central_get_peripheral_stats(uint8_t source,
+                                           struct zmk_split_central_peripheral_stats *stats);
+
+int zmk_split_get_peripheral_battery_level(uint8_t source, uint8_t *level);
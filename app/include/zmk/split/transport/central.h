@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/sys/iterable_sections.h>
+
+#include <zmk/split/transport/types.h>
+
+struct zmk_split_transport_central;
+
+struct zmk_split_transport_central_api {
+    // Sends a command to the peripheral with the given source ID. Returns -ENOTCONN if that
+    // peripheral isn't currently connected through this transport.
+    int (*send_command)(uint8_t source, struct zmk_split_transport_central_command cmd);
+};
+
+struct zmk_split_transport_central {
+    const struct zmk_split_transport_central_api *api;
+};
+
+/**
+ * Registers a central transport. Source IDs passed to and from the transport are shared between
+ * all registered transports, each transport only using the IDs of the peripherals it connects to.
+ */
+#define ZMK_SPLIT_TRANSPORT_CENTRAL_REGISTER(name, _api)                                           \
+    static const STRUCT_SECTION_ITERABLE(zmk_split_transport_central, name) = {                    \
+        .api = _api,                                                                               \
+    }
+
+/**
+ * Handles an event received from a peripheral. Key position events that don't change the known
+ * state of the peripheral are ignored, so transports may safely resend their full state.
+ */
+int zmk_split_transport_central_peripheral_event_handler(
+    const struct zmk_split_transport_central *transport, uint8_t source,
+    struct zmk_split_transport_peripheral_event ev);
+
+/**
+ * Notifies the central that a peripheral connected or disconnected. Commands for a peripheral are
+ * only sent while it is connected, and disconnecting releases any of its pressed key positions.
+ */
+int zmk_split_transport_central_peripheral_status_changed(
+    const struct zmk_split_transport_central *transport, uint8_t source, bool connected);
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/sys/iterable_sections.h>
+
+#include <zmk/split/transport/types.h>
+
+struct zmk_split_transport_peripheral;
+
+struct zmk_split_transport_peripheral_api {
+    // Sends an event to the central. Transports may drop event types they report some other way,
+    // e.g. battery levels already exposed through a standard service.
+    int (*report_event)(const struct zmk_split_transport_peripheral_event *event);
+};
+
+struct zmk_split_transport_peripheral {
+    const struct zmk_split_transport_peripheral_api *api;
+};
+
+#define ZMK_SPLIT_TRANSPORT_PERIPHERAL_REGISTER(name, _api)                                        \
+    static const STRUCT_SECTION_ITERABLE(zmk_split_transport_peripheral, name) = {                 \
+        .api = _api,                                                                               \
+    }
+
+/**
+ * Handles a command received from the central. Must not be called from an ISR.
+ */
+int zmk_split_transport_peripheral_command_handler(
+    const struct zmk_split_transport_peripheral *transport,
+    struct zmk_split_transport_central_command cmd);
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/types.h>
+
+#include <zmk/events/sensor_event.h>
+#include <zmk/hid_indicators_types.h>
+#include <zmk/sensors.h>
+
+enum zmk_split_transport_peripheral_event_type {
+    ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+    ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT,
+    ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT,
+};
+
+// Events sent from a peripheral to the central. Timestamps are in the uptime of the device
+// handling the event, so transports convert them when crossing between the halves.
+struct zmk_split_transport_peripheral_event {
+    enum zmk_split_transport_peripheral_event_type type;
+
+    union {
+        struct {
+            uint32_t position;
+            bool pressed;
+            int64_t timestamp;
+        } key_position_event;
+
+        struct {
+            uint8_t sensor_index;
+            uint8_t channel_data_size;
+            struct zmk_sensor_channel_data channel_data[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+        } sensor_event;
+
+        struct {
+            uint8_t level;
+        } battery_event;
+    } data;
+};
+
+enum zmk_split_transport_central_command_type {
+    ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
+    ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS,
+};
+
+// Commands sent from the central to a peripheral. The behavior device name is only valid while
+// the command is being handled, transports copy what they need of it before returning.
+struct zmk_split_transport_central_command {
+    enum zmk_split_transport_central_command_type type;
+
+    union {
+        struct {
+            const char *behavior_dev;
+            uint32_t param1;
+            uint32_t param2;
+            uint32_t position;
+            bool state;
+        } invoke_behavior;
+
+        struct {
+            zmk_hid_indicators_t indicators;
+        } set_hid_indicators;
+    } data;
+};
@@ -14,3 +14,7 @@ int zmk_usb_hid_send_consumer_report(void);
 int zmk_usb_hid_send_mouse_report(void);
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
 void zmk_usb_hid_set_protocol(uint8_t protocol);
+uint8_t zmk_usb_hid_get_protocol(void);
+
+// Drops all queued reports and any write in flight, e.g. when the host resets the device.
+void zmk_usb_hid_reset(void);
@@ -15,8 +15,10 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/init.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_utils.h>
 #include <zephyr/drivers/i2c.h>
 
 #define LOG_LEVEL CONFIG_GPIO_LOG_LEVEL
@@ -34,12 +36,18 @@ LOG_MODULE_REGISTER(gpio_max7318);
 #define REG_CONFIG_PORTA 0x06
 #define REG_CONFIG_PORTB 0x07
 
+#define MAX7318_HAS_INT DT_ANY_INST_HAS_PROP_STATUS_OKAY(int_gpios)
+
 // Configuration data
 struct max7318_config {
     struct gpio_driver_config common;
 
     struct i2c_dt_spec i2c_bus;
+    // The INT pin, if connected.
+    struct gpio_dt_spec int_gpio;
     uint8_t ngpios;
+    // Whether to only read the input registers again after INT goes active or a register write.
+    bool cache_inputs;
 };
 
 // Runtime driver data
@@ -53,7 +61,29 @@ struct max7318_drv_data {
         uint16_t ipol;
         uint16_t config;
         uint16_t output;
+        // Last value read from the input registers.
+        uint16_t input;
     } reg_cache;
+
+    // Whether reg_cache.input still matches the input registers, with cache-inputs. Cleared by the
+    // INT pin and by register writes, which can change the inputs, e.g. by driving a matrix row.
+    atomic_t input_valid;
+
+#if MAX7318_HAS_INT
+    const struct device *dev;
+    struct gpio_callback int_gpio_cb;
+    struct k_work interrupt_work;
+    sys_slist_t callbacks;
+
+    // Pins with a level interrupt enabled.
+    uint16_t int_level;
+    // Pins with an interrupt on the high level or rising edge.
+    uint16_t int_high;
+    // Pins with an interrupt on the low level or falling edge.
+    uint16_t int_low;
+    // Inputs as of the last interrupt, used to detect edges.
+    uint16_t int_input;
+#endif
 };
 
 /**
@@ -101,6 +131,7 @@ static int read_registers(const struct device *dev, uint8_t reg, uint16_t *buf)
  */
 static int write_registers(const struct device *dev, uint8_t reg, uint16_t value) {
     const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
 
     LOG_DBG("max7318: write: reg[0x%X] = 0x%X, reg[0x%X] = 0x%X", reg, (value & 0xFF), (reg + 1),
             (value >> 8));
@@ -111,9 +142,46 @@ static int write_registers(const struct device *dev, uint8_t reg, uint16_t value
     // -- ie. this is little endian also.
     sys_put_le16(value, &data[0]);
 
+    atomic_clear(&drv_data->input_valid);
+
     return i2c_burst_write_dt(&config->i2c_bus, reg, &data[0], sizeof(data));
 }
 
+/**
+ * @brief Read the input registers
+ *
+ * With cache-inputs, if no input changed since the last read, this returns the cached value
+ * without any bus transaction. Must be called with the lock held.
+ *
+ * @param dev   The max7318 device.
+ * @param value Buffer to read the inputs into.
+ *
+ * @return 0 if successful, failed otherwise.
+ */
+static int read_inputs(const struct device *dev, uint16_t *value) {
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    if (atomic_get(&drv_data->input_valid)) {
+        *value = drv_data->reg_cache.input;
+        return 0;
+    }
+
+    // Mark the cache valid before reading, so an interrupt during the read invalidates it again.
+    if (config->cache_inputs) {
+        atomic_set(&drv_data->input_valid, true);
+    }
+
+    int ret = read_registers(dev, REG_INPUT_PORTA, &drv_data->reg_cache.input);
+    if (ret != 0) {
+        atomic_clear(&drv_data->input_valid);
+        return ret;
+    }
+
+    *value = drv_data->reg_cache.input;
+    return 0;
+}
+
 /**
  * @brief Setup the pin direction (input or output)
  *
@@ -216,7 +284,7 @@ static int max7318_port_get_raw(const struct device *dev, uint32_t *value) {
     k_sem_take(&drv_data->lock, K_FOREVER);
 
     uint16_t buf = 0;
-    int ret = read_registers(dev, REG_INPUT_PORTA, &buf);
+    int ret = read_inputs(dev, &buf);
     if (ret != 0) {
         goto done;
     }
@@ -280,11 +348,144 @@ static int max7318_port_toggle_bits(const struct device *dev, uint32_t mask) {
     return ret;
 }
 
+#if MAX7318_HAS_INT
+
+/**
+ * @brief Read the inputs after the INT pin went active and fire the callbacks of the pins whose
+ *        interrupt condition is met.
+ *
+ * Level interrupts fire once per change of the inputs rather than continuously, which is enough
+ * for callers which disable the interrupt from the callback, such as the kscan drivers.
+ */
+static void max7318_interrupt_worker(struct k_work *work) {
+    struct max7318_drv_data *const drv_data =
+        CONTAINER_OF(work, struct max7318_drv_data, interrupt_work);
+    const struct device *dev = drv_data->dev;
+
+    k_sem_take(&drv_data->lock, K_FOREVER);
+
+    uint16_t input = 0;
+    int ret = read_inputs(dev, &input);
+    const uint16_t changed = input ^ drv_data->int_input;
+    const uint16_t triggered = (drv_data->int_high & input) | (drv_data->int_low & ~input);
+    const uint16_t fired = triggered & (drv_data->int_level | changed);
+
+    drv_data->int_input = input;
+
+    k_sem_give(&drv_data->lock);
+
+    if (ret != 0) {
+        LOG_ERR("error reading inputs after interrupt (%d)", ret);
+        return;
+    }
+
+    if (fired) {
+        gpio_fire_callbacks(&drv_data->callbacks, dev, fired);
+    }
+}
+
+static void max7318_int_gpio_handler(const struct device *port, struct gpio_callback *cb,
+                                     gpio_port_pins_t pins) {
+    struct max7318_drv_data *const drv_data =
+        CONTAINER_OF(cb, struct max7318_drv_data, int_gpio_cb);
+
+    atomic_clear(&drv_data->input_valid);
+    k_work_submit(&drv_data->interrupt_work);
+}
+
+static int max7318_pin_interrupt_configure(const struct device *dev, gpio_pin_t pin,
+                                           enum gpio_int_mode mode, enum gpio_int_trig trig) {
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    if (config->int_gpio.port == NULL) {
+        return -ENOTSUP;
+    }
+
+    if (mode == GPIO_INT_MODE_LEVEL && trig == GPIO_INT_TRIG_BOTH) {
+        return -ENOTSUP;
+    }
+
+    // This may be called from an ISR, so only update the masks here and let the worker read the
+    // inputs, which fires a level interrupt that is already active.
+    const unsigned int key = irq_lock();
+
+    WRITE_BIT(drv_data->int_level, pin, mode == GPIO_INT_MODE_LEVEL);
+    WRITE_BIT(drv_data->int_high, pin,
+              mode != GPIO_INT_MODE_DISABLED && (trig & GPIO_INT_TRIG_HIGH) != 0U);
+    WRITE_BIT(drv_data->int_low, pin,
+              mode != GPIO_INT_MODE_DISABLED && (trig & GPIO_INT_TRIG_LOW) != 0U);
+
+    irq_unlock(key);
+
+    if (mode == GPIO_INT_MODE_LEVEL) {
+        k_work_submit(&drv_data->interrupt_work);
+    }
+
+    return 0;
+}
+
+static int max7318_manage_callback(const struct device *dev, struct gpio_callback *callback,
+                                   bool set) {
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    return gpio_manage_callback(&drv_data->callbacks, callback, set);
+}
+
+/**
+ * @brief Set up the INT pin, if it is connected
+ *
+ * @param dev Device struct
+ * @return 0 if successful, failed otherwise.
+ */
+static int max7318_init_interrupt(const struct device *dev) {
+    const struct max7318_config *const config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    drv_data->dev = dev;
+    k_work_init(&drv_data->interrupt_work, max7318_interrupt_worker);
+
+    if (config->int_gpio.port == NULL) {
+        return 0;
+    }
+
+    if (!gpio_is_ready_dt(&config->int_gpio)) {
+        LOG_ERR("INT gpio not ready");
+        return -ENODEV;
+    }
+
+    int ret = gpio_pin_configure_dt(&config->int_gpio, GPIO_INPUT);
+    if (ret != 0) {
+        LOG_ERR("error configuring INT gpio (%d)", ret);
+        return ret;
+    }
+
+    gpio_init_callback(&drv_data->int_gpio_cb, max7318_int_gpio_handler,
+                       BIT(config->int_gpio.pin));
+    ret = gpio_add_callback(config->int_gpio.port, &drv_data->int_gpio_cb);
+    if (ret != 0) {
+        LOG_ERR("error adding INT gpio callback (%d)", ret);
+        return ret;
+    }
+
+    // Reading the inputs releases INT, so read them once before waiting for it to go active.
+    ret = read_registers(dev, REG_INPUT_PORTA, &drv_data->int_input);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return gpio_pin_interrupt_configure_dt(&config->int_gpio, GPIO_INT_EDGE_TO_ACTIVE);
+}
+
+#else
+
 static int max7318_pin_interrupt_configure(const struct device *dev, gpio_pin_t pin,
                                            enum gpio_int_mode mode, enum gpio_int_trig trig) {
     return -ENOTSUP;
 }
 
+#endif // MAX7318_HAS_INT
+
 static const struct gpio_driver_api api_table = {
     .pin_configure = max7318_config,
     .port_get_raw = max7318_port_get_raw,
@@ -293,6 +494,9 @@ static const struct gpio_driver_api api_table = {
     .port_clear_bits_raw = max7318_port_clear_bits_raw,
     .port_toggle_bits = max7318_port_toggle_bits,
     .pin_interrupt_configure = max7318_pin_interrupt_configure,
+#if MAX7318_HAS_INT
+    .manage_callback = max7318_manage_callback,
+#endif
 };
 
 /**
@@ -310,9 +514,17 @@ static int max7318_init(const struct device *dev) {
         return -EINVAL;
     }
 
+    k_sem_init(&drv_data->lock, 1, 1);
+
+#if MAX7318_HAS_INT
+    int ret = max7318_init_interrupt(dev);
+    if (ret != 0) {
+        return ret;
+    }
+#endif
+
     LOG_INF("device initialised at 0x%x", config->i2c_bus.addr);
 
-    k_sem_init(&drv_data->lock, 1, 1);
     return 0;
 }
 
@@ -322,9 +534,15 @@ static int max7318_init(const struct device *dev) {
     GPIO_PORT_PIN_MASK_FROM_NGPIOS(DT_INST_PROP(inst, ngpios))
 
 #define MAX7318_INIT(inst)                                                                         \
+    BUILD_ASSERT(!DT_INST_PROP(inst, cache_inputs) || DT_INST_NODE_HAS_PROP(inst, int_gpios),      \
+                 "cache-inputs requires int-gpios");                                               \
+                                                                                                   \
     static struct max7318_config max7318_##inst##_config = {                                       \
         .common = {.port_pin_mask = GPIO_PORT_PIN_MASK_FROM_DT_INST(inst)},                        \
-        .i2c_bus = I2C_DT_SPEC_INST_GET(inst)};                                                    \
+        .i2c_bus = I2C_DT_SPEC_INST_GET(inst),                                                     \
+        .int_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, int_gpios, {0}),                                \
+        .cache_inputs = DT_INST_PROP(inst, cache_inputs),                                          \
+    };                                                                                             \
                                                                                                    \
     static struct max7318_drv_data max7318_##inst##_drvdata = {                                    \
         /* Default for registers according to datasheet */                                         \
@@ -40,6 +40,19 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define KSCAN_GPIO_CFG_INIT(idx, inst_idx)                                                         \
     GPIO_DT_SPEC_GET_BY_IDX(DT_DRV_INST(inst_idx), gpios, idx)
 
+// Pull inputs towards the inactive level, so they only read active while driven by another pin.
+#define KSCAN_INPUT_FLAGS_INIT(idx, inst_idx)                                                      \
+    (GPIO_INPUT | ((DT_INST_GPIO_FLAGS_BY_IDX(inst_idx, gpios, idx) & GPIO_ACTIVE_LOW)             \
+                       ? GPIO_PULL_UP                                                              \
+                       : GPIO_PULL_DOWN))
+
+#define KSCAN_PIN_BIT_INIT(idx, inst_idx) BIT(DT_INST_GPIO_PIN_BY_IDX(inst_idx, gpios, idx))
+
+#define KSCAN_CELL_SAME_PORT(idx, inst_idx)                                                        \
+    DT_SAME_NODE(DT_INST_GPIO_CTLR_BY_IDX(inst_idx, gpios, idx),                                   \
+                 DT_INST_GPIO_CTLR_BY_IDX(inst_idx, gpios, 0))
+#define INST_CELLS_SHARE_PORT(n) (LISTIFY(INST_LEN(n), KSCAN_CELL_SAME_PORT, (&&), n))
+
 #define INST_INTR_DEFINED(n) DT_INST_NODE_HAS_PROP(n, interrupt_gpios)
 
 #define WITH_INTR(n) COND_CODE_1(INST_INTR_DEFINED(n), (+1), (+0))
@@ -77,6 +90,12 @@ struct kscan_gpio_list {
 
 struct kscan_charlieplex_config {
     struct kscan_gpio_list cells;
+    /** Flags to configure each cell as an input, precomputed from its devicetree flags. */
+    const gpio_flags_t *input_flags;
+    /** All cells are on the same port, so each output step reads them with one port read. */
+    bool read_port;
+    /** With read_port, the pin of each cell. */
+    const gpio_port_pins_t *pin_bits;
     struct zmk_debounce_config debounce_config;
     int32_t debounce_scan_period_ms;
     int32_t poll_period_ms;
@@ -115,21 +134,31 @@ static int kscan_charlieplex_set_as_input(const struct gpio_dt_spec *gpio) {
     return 0;
 }
 
-static int kscan_charlieplex_set_as_output(const struct gpio_dt_spec *gpio) {
-    if (!device_is_ready(gpio->port)) {
-        LOG_ERR("GPIO is not ready: %s", gpio->port->name);
-        return -ENODEV;
-    }
+/**
+ * Set a cell as an input during a scan. Unlike kscan_charlieplex_set_as_input(), this relies on
+ * the port readiness checked at setup and on the precomputed flags.
+ */
+static int kscan_charlieplex_scan_set_input(const struct device *dev, const int idx) {
+    const struct kscan_charlieplex_config *config = dev->config;
+    const struct gpio_dt_spec *gpio = &config->cells.gpios[idx];
 
-    int err = gpio_pin_configure_dt(gpio, GPIO_OUTPUT);
+    int err = gpio_pin_configure_dt(gpio, config->input_flags[idx]);
     if (err) {
-        LOG_ERR("Unable to configure pin %u on %s for output", gpio->pin, gpio->port->name);
-        return err;
+        LOG_ERR("Unable to configure pin %u on %s for input", gpio->pin, gpio->port->name);
     }
+    return err;
+}
 
-    err = gpio_pin_set_dt(gpio, 1);
+/**
+ * Set a cell as an active output during a scan, with a single configure call.
+ */
+static int kscan_charlieplex_scan_set_output(const struct device *dev, const int idx) {
+    const struct kscan_charlieplex_config *config = dev->config;
+    const struct gpio_dt_spec *gpio = &config->cells.gpios[idx];
+
+    int err = gpio_pin_configure_dt(gpio, GPIO_OUTPUT_ACTIVE);
     if (err) {
-        LOG_ERR("Failed to set output pin %u active: %i", gpio->pin, err);
+        LOG_ERR("Unable to configure pin %u on %s for output", gpio->pin, gpio->port->name);
     }
     return err;
 }
@@ -138,7 +167,7 @@ static int kscan_charlieplex_set_all_as_input(const struct device *dev) {
     const struct kscan_charlieplex_config *config = dev->config;
     int err = 0;
     for (int i = 0; i < config->cells.len; i++) {
-        err = kscan_charlieplex_set_as_input(&config->cells.gpios[i]);
+        err = kscan_charlieplex_scan_set_input(dev, i);
         if (err) {
             return err;
         }
@@ -257,7 +286,7 @@ static int kscan_charlieplex_read(const struct device *dev) {
     // Scan the matrix.
     for (int row = 0; row < config->cells.len; row++) {
         const struct gpio_dt_spec *out_gpio = &config->cells.gpios[row];
-        err = kscan_charlieplex_set_as_output(out_gpio);
+        err = kscan_charlieplex_scan_set_output(dev, row);
         if (err) {
             return err;
         }
@@ -266,15 +295,25 @@ static int kscan_charlieplex_read(const struct device *dev) {
         k_busy_wait(CONFIG_ZMK_KSCAN_CHARLIEPLEX_WAIT_BEFORE_INPUTS);
 #endif
 
+        gpio_port_value_t sensed = 0;
+        if (config->read_port) {
+            err = gpio_port_get(out_gpio->port, &sensed);
+            if (err) {
+                LOG_ERR("Failed to read port %s: %i", out_gpio->port->name, err);
+                return err;
+            }
+        }
+
         for (int col = 0; col < config->cells.len; col++) {
             if (col == row) {
                 continue; // pin can't drive itself
             }
-            const struct gpio_dt_spec *in_gpio = &config->cells.gpios[col];
             const int index = state_index(config, row, col);
+            const int active = config->read_port ? (sensed & config->pin_bits[col]) != 0
+                                                 : gpio_pin_get_dt(&config->cells.gpios[col]);
 
             struct zmk_debounce_state *state = &data->charlieplex_state[index];
-            zmk_debounce_update(state, gpio_pin_get_dt(in_gpio), config->debounce_scan_period_ms,
+            zmk_debounce_update(state, active, config->debounce_scan_period_ms,
                                 &config->debounce_config);
 
             // NOTE: RR vs MATRIX: because we don't need an input/output => row/column
@@ -288,7 +327,7 @@ static int kscan_charlieplex_read(const struct device *dev) {
             continue_scan = continue_scan || zmk_debounce_is_active(state);
         }
 
-        err = kscan_charlieplex_set_as_input(out_gpio);
+        err = kscan_charlieplex_scan_set_input(dev, row);
         if (err) {
             return err;
         }
@@ -441,12 +480,19 @@ static const struct kscan_driver_api kscan_charlieplex_api = {
     static struct zmk_debounce_state kscan_charlieplex_state_##n[INST_CHARLIEPLEX_LEN(n)];         \
     static const struct gpio_dt_spec kscan_charlieplex_cells_##n[] = {                             \
         LISTIFY(INST_LEN(n), KSCAN_GPIO_CFG_INIT, (, ), n)};                                       \
+    static const gpio_flags_t kscan_charlieplex_input_flags_##n[] = {                              \
+        LISTIFY(INST_LEN(n), KSCAN_INPUT_FLAGS_INIT, (, ), n)};                                    \
+    static const gpio_port_pins_t kscan_charlieplex_pin_bits_##n[] = {                             \
+        LISTIFY(INST_LEN(n), KSCAN_PIN_BIT_INIT, (, ), n)};                                        \
     static struct kscan_charlieplex_data kscan_charlieplex_data_##n = {                            \
         .charlieplex_state = kscan_charlieplex_state_##n,                                          \
     };                                                                                             \
                                                                                                    \
     static struct kscan_charlieplex_config kscan_charlieplex_config_##n = {                        \
         .cells = KSCAN_GPIO_LIST(kscan_charlieplex_cells_##n),                                     \
+        .input_flags = kscan_charlieplex_input_flags_##n,                                          \
+        .read_port = INST_CELLS_SHARE_PORT(n),                                                     \
+        .pin_bits = kscan_charlieplex_pin_bits_##n,                                                \
         .debounce_config =                                                                         \
             {                                                                                      \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
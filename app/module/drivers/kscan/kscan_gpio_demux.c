@@ -4,206 +4,405 @@
  * SPDX-License-Identifier: MIT
  */
 
-#define DT_DRV_COMPAT zmk_kscan_gpio_demux
+#include "kscan_gpio.h"
 
 #include <zephyr/device.h>
-#include <zephyr/drivers/kscan.h>
+#include <zephyr/devicetree.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/kscan.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/debounce.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
-// Helper macro
-#define PWR_TWO(x) (1 << (x))
+#define DT_DRV_COMPAT zmk_kscan_gpio_demux
 
-// Define row and col cfg
-#define _KSCAN_GPIO_CFG_INIT(n, prop, idx) GPIO_DT_SPEC_GET_BY_IDX(n, prop, idx),
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
+#define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
+#else
+#define INST_DEBOUNCE_PRESS_MS(n)                                                                  \
+    DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_press_ms))
+#endif
 
-// Check debounce config
-#define CHECK_DEBOUNCE_CFG(n, a, b) COND_CODE_0(DT_INST_PROP(n, debounce_period), a, b)
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS >= 0
+#define INST_DEBOUNCE_RELEASE_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS
+#else
+#define INST_DEBOUNCE_RELEASE_MS(n)                                                                \
+    DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_release_ms))
+#endif
 
-// Define the row and column lengths
-#define INST_MATRIX_INPUTS(n) DT_INST_PROP_LEN(n, input_gpios)
-#define INST_DEMUX_GPIOS(n) DT_INST_PROP_LEN(n, output_gpios)
-#define INST_MATRIX_OUTPUTS(n) PWR_TWO(INST_DEMUX_GPIOS(n))
-#define POLL_INTERVAL(n) DT_INST_PROP(n, polling_interval_msec)
+#define INST_INPUTS_LEN(n) DT_INST_PROP_LEN(n, input_gpios)
+#define INST_ADDRESS_LEN(n) DT_INST_PROP_LEN(n, output_gpios)
+#define INST_OUTPUTS_LEN(n) BIT(INST_ADDRESS_LEN(n))
+#define INST_MATRIX_LEN(n) (INST_INPUTS_LEN(n) * INST_OUTPUTS_LEN(n))
 
-#define GPIO_INST_INIT(n)                                                                          \
-    struct kscan_gpio_irq_callback_##n {                                                           \
-        struct CHECK_DEBOUNCE_CFG(n, (k_work), (k_work_delayable)) * work;                         \
-        struct gpio_callback callback;                                                             \
-        const struct device *dev;                                                                  \
-    };                                                                                             \
-                                                                                                   \
-    struct kscan_gpio_config_##n {                                                                 \
-        const struct gpio_dt_spec rows[INST_MATRIX_INPUTS(n)];                                     \
-        const struct gpio_dt_spec cols[INST_DEMUX_GPIOS(n)];                                       \
-    };                                                                                             \
-                                                                                                   \
-    struct kscan_gpio_data_##n {                                                                   \
-        kscan_callback_t callback;                                                                 \
-        struct k_timer poll_timer;                                                                 \
-        struct CHECK_DEBOUNCE_CFG(n, (k_work), (k_work_delayable)) work;                           \
-        bool matrix_state[INST_MATRIX_INPUTS(n)][INST_MATRIX_OUTPUTS(n)];                          \
-        const struct device *dev;                                                                  \
-    };                                                                                             \
-    /* IO/GPIO SETUP */                                                                            \
-    static const struct gpio_dt_spec *kscan_gpio_input_specs_##n(const struct device *dev) {       \
-        const struct kscan_gpio_config_##n *cfg = dev->config;                                     \
-        return cfg->rows;                                                                          \
-    }                                                                                              \
-                                                                                                   \
-    static const struct gpio_dt_spec *kscan_gpio_output_specs_##n(const struct device *dev) {      \
-        const struct kscan_gpio_config_##n *cfg = dev->config;                                     \
-        return cfg->cols;                                                                          \
-    }                                                                                              \
-    /* POLLING SETUP */                                                                            \
-    static void kscan_gpio_timer_handler(struct k_timer *timer) {                                  \
-        struct kscan_gpio_data_##n *data =                                                         \
-            CONTAINER_OF(timer, struct kscan_gpio_data_##n, poll_timer);                           \
-        k_work_submit(&data->work.work);                                                           \
-    }                                                                                              \
-                                                                                                   \
-    /* Read the state of the input GPIOs */                                                        \
-    /* This is the core matrix_scan func */                                                        \
-    static int kscan_gpio_read_##n(const struct device *dev) {                                     \
-        bool submit_follow_up_read = false;                                                        \
-        struct kscan_gpio_data_##n *data = dev->data;                                              \
-        static bool read_state[INST_MATRIX_INPUTS(n)][INST_MATRIX_OUTPUTS(n)];                     \
-        for (int o = 0; o < INST_MATRIX_OUTPUTS(n); o++) {                                         \
-            /* Iterate over bits and set GPIOs accordingly */                                      \
-            for (uint8_t bit = 0; bit < INST_DEMUX_GPIOS(n); bit++) {                              \
-                uint8_t state = (o & (0b1 << bit)) >> bit;                                         \
-                const struct gpio_dt_spec *out_spec = &kscan_gpio_output_specs_##n(dev)[bit];      \
-                gpio_pin_set_dt(out_spec, state);                                                  \
-            }                                                                                      \
-            /* Let the col settle before reading the rows */                                       \
-            k_usleep(1);                                                                           \
-                                                                                                   \
-            for (int i = 0; i < INST_MATRIX_INPUTS(n); i++) {                                      \
-                /* Get the input spec */                                                           \
-                const struct gpio_dt_spec *in_spec = &kscan_gpio_input_specs_##n(dev)[i];          \
-                read_state[i][o] = gpio_pin_get_dt(in_spec) > 0;                                   \
-            }                                                                                      \
-        }                                                                                          \
-        for (int r = 0; r < INST_MATRIX_INPUTS(n); r++) {                                          \
-            for (int c = 0; c < INST_MATRIX_OUTPUTS(n); c++) {                                     \
-                bool pressed = read_state[r][c];                                                   \
-                submit_follow_up_read = (submit_follow_up_read || pressed);                        \
-                if (pressed != data->matrix_state[r][c]) {                                         \
-                    LOG_DBG("Sending event at %d,%d state %s", r, c, (pressed ? "on" : "off"));    \
-                    data->matrix_state[r][c] = pressed;                                            \
-                    data->callback(dev, r, c, pressed);                                            \
-                }                                                                                  \
-            }                                                                                      \
-        }                                                                                          \
-        if (submit_follow_up_read) {                                                               \
-            CHECK_DEBOUNCE_CFG(n, ({ k_work_submit(&data->work); }),                               \
-                               ({ k_work_reschedule(&data->work, K_MSEC(5)); }))                   \
-        }                                                                                          \
-        return 0;                                                                                  \
-    }                                                                                              \
-                                                                                                   \
-    static void kscan_gpio_work_handler_##n(struct k_work *work) {                                 \
-        struct k_work_delayable *d_work = k_work_delayable_from_work(work);                        \
-        struct kscan_gpio_data_##n *data = CONTAINER_OF(d_work, struct kscan_gpio_data_##n, work); \
-        kscan_gpio_read_##n(data->dev);                                                            \
-    }                                                                                              \
+#define KSCAN_GPIO_INPUT_CFG_INIT(idx, inst_idx)                                                   \
+    KSCAN_GPIO_GET_BY_IDX(DT_DRV_INST(inst_idx), input_gpios, idx)
+#define KSCAN_GPIO_ADDRESS_CFG_INIT(idx, inst_idx)                                                 \
+    GPIO_DT_SPEC_GET_BY_IDX(DT_DRV_INST(inst_idx), output_gpios, idx)
+
+struct kscan_demux_data {
+    const struct device *dev;
+    struct kscan_gpio_list inputs;
+    kscan_callback_t callback;
+    struct k_work_delayable work;
+    /** Timestamp of the current or scheduled scan. */
+    int64_t scan_time;
+    /** Output currently selected by the address pins, or -1 if unknown. */
+    int selected_output;
+    /**
+     * Current state of the matrix as a flattened 2D array of length
+     * (config->inputs.len * config->outputs)
+     */
+    struct zmk_debounce_state *matrix_state;
+};
+
+struct kscan_demux_config {
+    /** Address pins of the demultiplexer, least significant bit first. */
+    const struct gpio_dt_spec *address;
+    size_t address_len;
+    /** Number of demultiplexer outputs, which is 2 ^ address_len. */
+    size_t outputs;
+    struct zmk_debounce_config debounce_config;
+    int32_t debounce_scan_period_ms;
+    int32_t poll_period_ms;
+};
+
+/**
+ * Get the index into a matrix state array from an input and an output.
+ */
+static int state_index(const struct device *dev, const int input, const int output) {
+    const struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    __ASSERT(input < data->inputs.len, "Invalid input %i", input);
+    __ASSERT(output < config->outputs, "Invalid output %i", output);
+
+    return (input * config->outputs) + output;
+}
+
+/**
+ * Set the address pins to select an output, changing only the pins which differ from the
+ * currently selected output.
+ */
+static int kscan_demux_select_output(const struct device *dev, const int output) {
+    struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    const uint32_t changed = data->selected_output < 0 ? BIT_MASK(config->address_len)
+                                                       : (output ^ data->selected_output);
+
+    for (int bit = 0; bit < config->address_len; bit++) {
+        if (!(changed & BIT(bit))) {
+            continue;
+        }
+
+        const int err = gpio_pin_set_dt(&config->address[bit], (output >> bit) & 1);
+        if (err) {
+            LOG_ERR("Failed to set address pin %i: %i", bit, err);
+            data->selected_output = -1;
+            return err;
+        }
+    }
+
+    data->selected_output = output;
+    return 0;
+}
+
+static void kscan_demux_read_continue(const struct device *dev) {
+    const struct kscan_demux_config *config = dev->config;
+    struct kscan_demux_data *data = dev->data;
+
+    data->scan_time += config->debounce_scan_period_ms;
+
+    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+}
+
+static void kscan_demux_read_end(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    data->scan_time += config->poll_period_ms;
+
+    // Return to polling slowly.
+    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+}
+
+static int kscan_demux_read(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    // Scan the matrix.
+    for (int i = 0; i < config->outputs; i++) {
+        // Step through the outputs in Gray code order, so each step changes one address pin.
+        const int output = i ^ (i >> 1);
+
+        int err = kscan_demux_select_output(dev, output);
+        if (err) {
+            return err;
+        }
+
+        // Let the output settle before reading the inputs.
+        k_busy_wait(1);
+
+        struct kscan_gpio_port_state state = {0};
+
+        for (int j = 0; j < data->inputs.len; j++) {
+            const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
+
+            const int active = kscan_gpio_pin_get(in_gpio, &state);
+            if (active < 0) {
+                LOG_ERR("Failed to read port %s: %i", in_gpio->spec.port->name, active);
+                return active;
+            }
+
+            zmk_debounce_update(&data->matrix_state[state_index(dev, in_gpio->index, output)],
+                                active, config->debounce_scan_period_ms,
+                                &config->debounce_config);
+        }
+    }
+
+    // Process the new state.
+    bool continue_scan = false;
+
+    for (int input = 0; input < data->inputs.len; input++) {
+        for (int output = 0; output < config->outputs; output++) {
+            struct zmk_debounce_state *state =
+                &data->matrix_state[state_index(dev, input, output)];
+
+            if (zmk_debounce_get_changed(state)) {
+                const bool pressed = zmk_debounce_is_pressed(state);
+
+                LOG_DBG("Sending event at %i,%i state %s", input, output, pressed ? "on" : "off");
+                data->callback(dev, input, output, pressed);
+            }
+
+            continue_scan = continue_scan || zmk_debounce_is_active(state);
+        }
+    }
+
+    if (continue_scan) {
+        // At least one key is pressed or the debouncer has not yet decided if
+        // it is pressed. Poll quickly until everything is released.
+        kscan_demux_read_continue(dev);
+    } else {
+        // All keys are released. Return to normal.
+        kscan_demux_read_end(dev);
+    }
+
+    return 0;
+}
+
+static void kscan_demux_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = CONTAINER_OF(work, struct k_work_delayable, work);
+    struct kscan_demux_data *data = CONTAINER_OF(dwork, struct kscan_demux_data, work);
+    kscan_demux_read(data->dev);
+}
+
+static int kscan_demux_configure(const struct device *dev, kscan_callback_t callback) {
+    struct kscan_demux_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->callback = callback;
+    return 0;
+}
+
+static int kscan_demux_enable(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+
+    data->scan_time = k_uptime_get();
+
+    // Read will automatically start polling once done.
+    return kscan_demux_read(dev);
+}
+
+static int kscan_demux_disable(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+
+    k_work_cancel_delayable(&data->work);
+    return 0;
+}
+
+static int kscan_demux_init_input_inst(const struct device *dev, const struct kscan_gpio *gpio) {
+    if (!gpio_is_ready_dt(&gpio->spec)) {
+        LOG_ERR("GPIO is not ready: %s", gpio->spec.port->name);
+        return -ENODEV;
+    }
+
+    int err = gpio_pin_configure_dt(&gpio->spec, GPIO_INPUT);
+    if (err) {
+        LOG_ERR("Unable to configure pin %u on %s for input", gpio->spec.pin,
+                gpio->spec.port->name);
+        return err;
+    }
+
+    LOG_DBG("Configured pin %u on %s for input", gpio->spec.pin, gpio->spec.port->name);
+
+    return 0;
+}
+
+static int kscan_demux_init_address_inst(const struct device *dev,
+                                         const struct gpio_dt_spec *gpio) {
+    if (!gpio_is_ready_dt(gpio)) {
+        LOG_ERR("GPIO is not ready: %s", gpio->port->name);
+        return -ENODEV;
+    }
+
+    int err = gpio_pin_configure_dt(gpio, GPIO_OUTPUT_INACTIVE);
+    if (err) {
+        LOG_ERR("Unable to configure pin %u on %s for output", gpio->pin, gpio->port->name);
+        return err;
+    }
+
+    LOG_DBG("Configured pin %u on %s for output", gpio->pin, gpio->port->name);
+
+    return 0;
+}
+
+static int kscan_demux_setup_pins(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    for (int i = 0; i < data->inputs.len; i++) {
+        int err = kscan_demux_init_input_inst(dev, &data->inputs.gpios[i]);
+        if (err) {
+            return err;
+        }
+    }
+
+    for (int i = 0; i < config->address_len; i++) {
+        int err = kscan_demux_init_address_inst(dev, &config->address[i]);
+        if (err) {
+            return err;
+        }
+    }
+
+    data->selected_output = 0;
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_PM_DEVICE)
+
+static int kscan_demux_disconnect_pins(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+    const struct kscan_demux_config *config = dev->config;
+
+    for (int i = 0; i < data->inputs.len; i++) {
+        int err = gpio_pin_configure_dt(&data->inputs.gpios[i].spec, GPIO_DISCONNECTED);
+        if (err) {
+            return err;
+        }
+    }
+
+    for (int i = 0; i < config->address_len; i++) {
+        int err = gpio_pin_configure_dt(&config->address[i], GPIO_DISCONNECTED);
+        if (err) {
+            return err;
+        }
+    }
+
+    data->selected_output = -1;
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_PM_DEVICE)
+
+static int kscan_demux_init(const struct device *dev) {
+    struct kscan_demux_data *data = dev->data;
+
+    data->dev = dev;
+    data->selected_output = -1;
+
+    // Sort inputs by port so we can read each port just once per output.
+    kscan_gpio_list_sort_by_port(&data->inputs);
+
+    k_work_init_delayable(&data->work, kscan_demux_work_handler);
+
+#if IS_ENABLED(CONFIG_PM_DEVICE)
+    pm_device_init_suspended(dev);
+
+#if IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME)
+    pm_device_runtime_enable(dev);
+#endif
+
+#else
+    kscan_demux_setup_pins(dev);
+#endif
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_PM_DEVICE)
+
+static int kscan_demux_pm_action(const struct device *dev, enum pm_device_action action) {
+    switch (action) {
+    case PM_DEVICE_ACTION_SUSPEND:
+        kscan_demux_disconnect_pins(dev);
+        return kscan_demux_disable(dev);
+    case PM_DEVICE_ACTION_RESUME:
+        kscan_demux_setup_pins(dev);
+        return kscan_demux_enable(dev);
+    default:
+        return -ENOTSUP;
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_PM_DEVICE)
+
+static const struct kscan_driver_api kscan_demux_api = {
+    .config = kscan_demux_configure,
+    .enable_callback = kscan_demux_enable,
+    .disable_callback = kscan_demux_disable,
+};
+
+#define KSCAN_DEMUX_INIT(n)                                                                        \
+    BUILD_ASSERT(INST_DEBOUNCE_PRESS_MS(n) <= DEBOUNCE_COUNTER_MAX,                                \
+                 "ZMK_KSCAN_DEBOUNCE_PRESS_MS or debounce-press-ms is too large");                 \
+    BUILD_ASSERT(INST_DEBOUNCE_RELEASE_MS(n) <= DEBOUNCE_COUNTER_MAX,                              \
+                 "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
+    BUILD_ASSERT(INST_ADDRESS_LEN(n) <= 8, "Too many output-gpios");                               \
                                                                                                    \
-    static struct kscan_gpio_data_##n kscan_gpio_data_##n = {};                                    \
+    static struct kscan_gpio kscan_demux_inputs_##n[] = {                                          \
+        LISTIFY(INST_INPUTS_LEN(n), KSCAN_GPIO_INPUT_CFG_INIT, (, ), n)};                          \
                                                                                                    \
-    /* KSCAN API configure function */                                                             \
-    static int kscan_gpio_configure_##n(const struct device *dev, kscan_callback_t callback) {     \
-        LOG_DBG("KSCAN API configure");                                                            \
-        struct kscan_gpio_data_##n *data = dev->data;                                              \
-        if (!callback) {                                                                           \
-            return -EINVAL;                                                                        \
-        }                                                                                          \
-        data->callback = callback;                                                                 \
-        LOG_DBG("Configured GPIO %d", n);                                                          \
-        return 0;                                                                                  \
-    };                                                                                             \
+    static const struct gpio_dt_spec kscan_demux_address_##n[] = {                                 \
+        LISTIFY(INST_ADDRESS_LEN(n), KSCAN_GPIO_ADDRESS_CFG_INIT, (, ), n)};                       \
                                                                                                    \
-    /* KSCAN API enable function */                                                                \
-    static int kscan_gpio_enable_##n(const struct device *dev) {                                   \
-        LOG_DBG("KSCAN API enable");                                                               \
-        struct kscan_gpio_data_##n *data = dev->data;                                              \
-        /* TODO: we might want a follow up to hook into the sleep state hooks in Zephyr, */        \
-        /* and disable this timer when we enter a sleep state */                                   \
-        k_timer_start(&data->poll_timer, K_MSEC(POLL_INTERVAL(n)), K_MSEC(POLL_INTERVAL(n)));      \
-        return 0;                                                                                  \
-    };                                                                                             \
+    static struct zmk_debounce_state kscan_demux_state_##n[INST_MATRIX_LEN(n)];                    \
                                                                                                    \
-    /* KSCAN API disable function */                                                               \
-    static int kscan_gpio_disable_##n(const struct device *dev) {                                  \
-        LOG_DBG("KSCAN API disable");                                                              \
-        struct kscan_gpio_data_##n *data = dev->data;                                              \
-        k_timer_stop(&data->poll_timer);                                                           \
-        return 0;                                                                                  \
+    static struct kscan_demux_data kscan_demux_data_##n = {                                        \
+        .inputs = KSCAN_GPIO_LIST(kscan_demux_inputs_##n),                                         \
+        .matrix_state = kscan_demux_state_##n,                                                     \
     };                                                                                             \
                                                                                                    \
-    /* GPIO init function*/                                                                        \
-    static int kscan_gpio_init_##n(const struct device *dev) {                                     \
-        LOG_DBG("KSCAN GPIO init");                                                                \
-        struct kscan_gpio_data_##n *data = dev->data;                                              \
-        int err;                                                                                   \
-        /* configure input devices*/                                                               \
-        for (int i = 0; i < INST_MATRIX_INPUTS(n); i++) {                                          \
-            const struct gpio_dt_spec *in_spec = &kscan_gpio_input_specs_##n(dev)[i];              \
-            if (!device_is_ready(in_spec->port)) {                                                 \
-                LOG_ERR("Unable to find input GPIO device");                                       \
-                return -EINVAL;                                                                    \
-            }                                                                                      \
-            err = gpio_pin_configure_dt(in_spec, GPIO_INPUT);                                      \
-            if (err) {                                                                             \
-                LOG_ERR("Unable to configure pin %d for input", in_spec->pin);                     \
-                return err;                                                                        \
-            } else {                                                                               \
-                LOG_DBG("Configured pin %d for input", in_spec->pin);                              \
-            }                                                                                      \
-            if (err) {                                                                             \
-                LOG_ERR("Error adding the callback to the column device");                         \
-                return err;                                                                        \
-            }                                                                                      \
-        }                                                                                          \
-        /* configure output devices*/                                                              \
-        for (int o = 0; o < INST_DEMUX_GPIOS(n); o++) {                                            \
-            const struct gpio_dt_spec *out_spec = &kscan_gpio_output_specs_##n(dev)[o];            \
-            if (!device_is_ready(out_spec->port)) {                                                \
-                LOG_ERR("Unable to find output GPIO device");                                      \
-                return -EINVAL;                                                                    \
-            }                                                                                      \
-            err = gpio_pin_configure_dt(out_spec, GPIO_OUTPUT_ACTIVE);                             \
-            if (err) {                                                                             \
-                LOG_ERR("Unable to configure pin %d for output", out_spec->pin);                   \
-                return err;                                                                        \
-            } else {                                                                               \
-                LOG_DBG("Configured pin %d for output", out_spec->pin);                            \
-            }                                                                                      \
-        }                                                                                          \
-        data->dev = dev;                                                                           \
-                                                                                                   \
-        k_timer_init(&data->poll_timer, kscan_gpio_timer_handler, NULL);                           \
-                                                                                                   \
-        (CHECK_DEBOUNCE_CFG(n, (k_work_init), (k_work_init_delayable)))(                           \
-            &data->work, kscan_gpio_work_handler_##n);                                             \
-        return 0;                                                                                  \
-    }                                                                                              \
-                                                                                                   \
-    static const struct kscan_driver_api gpio_driver_api_##n = {                                   \
-        .config = kscan_gpio_configure_##n,                                                        \
-        .enable_callback = kscan_gpio_enable_##n,                                                  \
-        .disable_callback = kscan_gpio_disable_##n,                                                \
+    static const struct kscan_demux_config kscan_demux_config_##n = {                              \
+        .address = kscan_demux_address_##n,                                                        \
+        .address_len = INST_ADDRESS_LEN(n),                                                        \
+        .outputs = INST_OUTPUTS_LEN(n),                                                            \
+        .debounce_config =                                                                         \
+            {                                                                                      \
+                .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
+                .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .eager_press = DT_INST_PROP(n, debounce_eager_press),                              \
+            },                                                                                     \
+        .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .poll_period_ms = DT_INST_PROP(n, polling_interval_msec),                                  \
     };                                                                                             \
                                                                                                    \
-    static const struct kscan_gpio_config_##n kscan_gpio_config_##n = {                            \
-        .rows = {DT_FOREACH_PROP_ELEM(DT_DRV_INST(n), input_gpios, _KSCAN_GPIO_CFG_INIT)},         \
-        .cols = {DT_FOREACH_PROP_ELEM(DT_DRV_INST(n), output_gpios, _KSCAN_GPIO_CFG_INIT)},        \
-    };                                                                                             \
+    PM_DEVICE_DT_INST_DEFINE(n, kscan_demux_pm_action);                                            \
                                                                                                    \
-    DEVICE_DT_INST_DEFINE(n, kscan_gpio_init_##n, NULL, &kscan_gpio_data_##n,                      \
-                          &kscan_gpio_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,         \
-                          &gpio_driver_api_##n);
+    DEVICE_DT_INST_DEFINE(n, &kscan_demux_init, PM_DEVICE_DT_INST_GET(n), &kscan_demux_data_##n,   \
+                          &kscan_demux_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,        \
+                          &kscan_demux_api);
 
-DT_INST_FOREACH_STATUS_OKAY(GPIO_INST_INIT)
+DT_INST_FOREACH_STATUS_OKAY(KSCAN_DEMUX_INIT);
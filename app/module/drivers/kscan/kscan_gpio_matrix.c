@@ -11,12 +11,19 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/kscan.h>
 #include <zephyr/pm/device.h>
+#include <zephyr/init.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include <zephyr/sys/math_extras.h>
 #include <zephyr/sys/util.h>
 
 #include <zmk/debounce.h>
+#include <zmk/kscan_ghost.h>
+
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -30,6 +37,9 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define INST_COLS_LEN(n) DT_INST_PROP_LEN(n, col_gpios)
 #define INST_MATRIX_LEN(n) (INST_ROWS_LEN(n) * INST_COLS_LEN(n))
 #define INST_INPUTS_LEN(n) COND_DIODE_DIR(n, (INST_COLS_LEN(n)), (INST_ROWS_LEN(n)))
+#define INST_OUTPUTS_LEN(n) COND_DIODE_DIR(n, (INST_ROWS_LEN(n)), (INST_COLS_LEN(n)))
+#define INST_ACTIVE_CELLS_LEN(n) DIV_ROUND_UP(INST_MATRIX_LEN(n), 32)
+#define INST_INPUTS_PROP(n) COND_DIODE_DIR(n, (col_gpios), (row_gpios))
 
 #if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
 #define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
@@ -45,6 +55,27 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
     DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_release_ms))
 #endif
 
+#if CONFIG_ZMK_KSCAN_MATRIX_SCAN_PERIOD_US > 0
+#define INST_SCAN_PERIOD_US(n) CONFIG_ZMK_KSCAN_MATRIX_SCAN_PERIOD_US
+#else
+#define INST_SCAN_PERIOD_US(n) (DT_INST_PROP(n, debounce_scan_period_ms) * USEC_PER_MSEC)
+#endif
+
+#define INST_INPUT_ON_FIRST_PORT(idx, n)                                                           \
+    DT_SAME_NODE(DT_INST_GPIO_CTLR_BY_IDX(n, INST_INPUTS_PROP(n), idx),                            \
+                 DT_INST_GPIO_CTLR_BY_IDX(n, INST_INPUTS_PROP(n), 0))
+#define INST_DEBOUNCE_SCANS(n, ms) DIV_ROUND_UP((ms) * USEC_PER_MSEC, INST_SCAN_PERIOD_US(n))
+
+/*
+ * Whether all inputs can be read and debounced a port at a time, which needs them to be on the same
+ * port and the debounce times to fit the vertical debouncer, which counts scans instead of
+ * milliseconds.
+ */
+#define INST_SCAN_PORT(n)                                                                          \
+    ((LISTIFY(INST_INPUTS_LEN(n), INST_INPUT_ON_FIRST_PORT, (&&), n)) &&                           \
+     INST_DEBOUNCE_SCANS(n, INST_DEBOUNCE_PRESS_MS(n)) <= DEBOUNCE_VERTICAL_COUNTER_MAX &&         \
+     INST_DEBOUNCE_SCANS(n, INST_DEBOUNCE_RELEASE_MS(n)) <= DEBOUNCE_VERTICAL_COUNTER_MAX)
+
 #define USE_POLLING IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_POLLING)
 #define USE_INTERRUPTS (!USE_POLLING)
 
@@ -57,11 +88,30 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define KSCAN_GPIO_COL_CFG_INIT(idx, inst_idx)                                                     \
     KSCAN_GPIO_GET_BY_IDX(DT_DRV_INST(inst_idx), col_gpios, idx)
 
+#define USE_SCAN_STATS IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_SCAN_STATS)
+#define USE_SCAN_STATS_SHELL (USE_SCAN_STATS && IS_ENABLED(CONFIG_SHELL))
+
+#if USE_SCAN_STATS
+// Scan jitter histogram bucket i counts scans starting less than (SCAN_JITTER_BUCKET_MIN_US << i)
+// microseconds late. The last bucket counts every scan later than that.
+#define SCAN_JITTER_BUCKETS 8
+#define SCAN_JITTER_BUCKET_MIN_US 16
+#endif
+
 enum kscan_diode_direction {
     KSCAN_ROW2COL,
     KSCAN_COL2ROW,
 };
 
+#if USE_SCAN_STATS
+struct kscan_matrix_scan_stats {
+    uint32_t jitter_histogram[SCAN_JITTER_BUCKETS];
+    /** Scans which started a full scan period or more late. */
+    uint32_t overruns;
+    uint32_t max_jitter_us;
+};
+#endif
+
 struct kscan_matrix_irq_callback {
     const struct device *dev;
     struct gpio_callback callback;
@@ -76,13 +126,41 @@ struct kscan_matrix_data {
     /** Array of length config->inputs.len */
     struct kscan_matrix_irq_callback *irqs;
 #endif
-    /** Timestamp of the current or scheduled scan. */
-    int64_t scan_time;
+    /** Timestamp of the current or scheduled scan in microseconds. */
+    int64_t scan_time_us;
+    /** Time scanned but not yet passed to the debouncer in microseconds. */
+    uint32_t debounce_elapsed_us;
     /**
      * Current state of the matrix as a flattened 2D array of length
-     * (config->rows * config->cols)
+     * (config->rows * config->cols). Empty with config->scan_port.
      */
     struct zmk_debounce_state *matrix_state;
+    /**
+     * Bitmap of the matrix_state entries which are active or changed in the last scan, so only
+     * those need to be processed after a scan. Array of length INST_ACTIVE_CELLS_LEN, empty with
+     * config->scan_port.
+     */
+    uint32_t *active_cells;
+    /**
+     * Debounce state of the inputs for each output, with one bit per input pin, used instead of
+     * matrix_state with config->scan_port. Array of length config->outputs.len, empty without it.
+     */
+    struct zmk_debounce_vertical_state *port_state;
+    /** Pins of all inputs, when scanning the inputs a port at a time. */
+    gpio_port_pins_t port_inputs;
+    struct zmk_debounce_vertical_config port_debounce_config;
+    /**
+     * With ghost detection, the debounced inputs pressed for each output and those reported to the
+     * callback, as bitmaps indexed by the input index. Arrays of length config->outputs.len, NULL
+     * without ghost detection.
+     */
+    uint32_t *pressed_inputs;
+    uint32_t *reported_inputs;
+    /** Whether pressed_inputs changed since the last ghost resolution. */
+    bool pressed_inputs_changed;
+#if USE_SCAN_STATS
+    struct kscan_matrix_scan_stats scan_stats;
+#endif
 };
 
 struct kscan_matrix_config {
@@ -90,9 +168,12 @@ struct kscan_matrix_config {
     struct zmk_debounce_config debounce_config;
     size_t rows;
     size_t cols;
-    int32_t debounce_scan_period_ms;
+    int32_t debounce_scan_period_us;
     int32_t poll_period_ms;
     enum kscan_diode_direction diode_direction;
+    bool ghost_detection;
+    /** Whether the inputs are read and debounced a port at a time, see INST_SCAN_PORT. */
+    bool scan_port;
 };
 
 /**
@@ -115,15 +196,95 @@ static int state_index_io(const struct kscan_matrix_config *config, const int in
                : state_index_rc(config, input_idx, output_idx);
 }
 
+static int64_t kscan_matrix_uptime_us(void) { return k_ticks_to_us_floor64(k_uptime_ticks()); }
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_SCAN_THREAD)
+K_THREAD_STACK_DEFINE(kscan_matrix_scan_q_stack, CONFIG_ZMK_KSCAN_MATRIX_SCAN_THREAD_STACK_SIZE);
+
+static struct k_work_q kscan_matrix_scan_q;
+
+static int kscan_matrix_scan_q_init(void) {
+    static const struct k_work_queue_config queue_config = {.name = "Matrix Scan Queue"};
+    k_work_queue_start(&kscan_matrix_scan_q, kscan_matrix_scan_q_stack,
+                       K_THREAD_STACK_SIZEOF(kscan_matrix_scan_q_stack),
+                       CONFIG_ZMK_KSCAN_MATRIX_SCAN_THREAD_PRIORITY, &queue_config);
+    return 0;
+}
+
+SYS_INIT(kscan_matrix_scan_q_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#endif // IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_SCAN_THREAD)
+
+static void kscan_matrix_schedule(struct kscan_matrix_data *data, const k_timeout_t delay) {
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_SCAN_THREAD)
+    k_work_reschedule_for_queue(&kscan_matrix_scan_q, &data->work, delay);
+#else
+    k_work_reschedule(&data->work, delay);
+#endif
+}
+
 static int kscan_matrix_set_all_outputs(const struct device *dev, const int value) {
     const struct kscan_matrix_config *config = dev->config;
 
-    for (int i = 0; i < config->outputs.len; i++) {
-        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+    // Set each run of outputs on the same port with one port write. On expanders such as the
+    // 74HC595, every write is a bus transaction.
+    for (int i = 0; i < config->outputs.len;) {
+        const struct device *port = config->outputs.gpios[i].spec.port;
+        gpio_port_pins_t mask = 0;
+
+        for (; i < config->outputs.len && config->outputs.gpios[i].spec.port == port; i++) {
+            mask |= BIT(config->outputs.gpios[i].spec.pin);
+        }
+
+        int err = gpio_port_set_masked(port, mask, value ? mask : 0);
+        if (err) {
+            LOG_ERR("Failed to set outputs on %s to %i: %i", port->name, value, err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Set output i inactive and the next output, if any, active.
+ *
+ * If both outputs are on the same port and there is no wait between outputs, this is a single port
+ * write, so stepping through outputs on an expander costs one bus transaction per output.
+ */
+static int kscan_matrix_next_output(const struct device *dev, const int i) {
+    const struct kscan_matrix_config *config = dev->config;
+    const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
+    const struct kscan_gpio *next_gpio =
+        i + 1 < config->outputs.len ? &config->outputs.gpios[i + 1] : NULL;
+    int err;
+
+    if (CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS == 0 && next_gpio &&
+        next_gpio->spec.port == out_gpio->spec.port) {
+        const gpio_port_pins_t next_bit = BIT(next_gpio->spec.pin);
+
+        err = gpio_port_set_masked(out_gpio->spec.port, BIT(out_gpio->spec.pin) | next_bit,
+                                   next_bit);
+        if (err) {
+            LOG_ERR("Failed to step from output %i to %i: %i", out_gpio->index, next_gpio->index,
+                    err);
+        }
+        return err;
+    }
+
+    err = gpio_pin_set_dt(&out_gpio->spec, 0);
+    if (err) {
+        LOG_ERR("Failed to set output %i inactive: %i", out_gpio->index, err);
+        return err;
+    }
+
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
+    k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
+#endif
 
-        int err = gpio_pin_set_dt(gpio, value);
+    if (next_gpio) {
+        err = gpio_pin_set_dt(&next_gpio->spec, 1);
         if (err) {
-            LOG_ERR("Failed to set output %i to %i: %i", i, value, err);
+            LOG_ERR("Failed to set output %i active: %i", next_gpio->index, err);
             return err;
         }
     }
@@ -185,9 +346,9 @@ static void kscan_matrix_irq_callback_handler(const struct device *port, struct
     // Disable our interrupts temporarily to avoid re-entry while we scan.
     kscan_matrix_interrupt_disable(data->dev);
 
-    data->scan_time = k_uptime_get();
+    data->scan_time_us = kscan_matrix_uptime_us();
 
-    k_work_reschedule(&data->work, K_NO_WAIT);
+    kscan_matrix_schedule(data, K_NO_WAIT);
 }
 #endif
 
@@ -195,9 +356,9 @@ static void kscan_matrix_read_continue(const struct device *dev) {
     const struct kscan_matrix_config *config = dev->config;
     struct kscan_matrix_data *data = dev->data;
 
-    data->scan_time += config->debounce_scan_period_ms;
+    data->scan_time_us += config->debounce_scan_period_us;
 
-    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+    kscan_matrix_schedule(data, K_TIMEOUT_ABS_US(data->scan_time_us));
 }
 
 static void kscan_matrix_read_end(const struct device *dev) {
@@ -208,76 +369,263 @@ static void kscan_matrix_read_end(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
 
-    data->scan_time += config->poll_period_ms;
+    data->scan_time_us += config->poll_period_ms * USEC_PER_MSEC;
 
     // Return to polling slowly.
-    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+    kscan_matrix_schedule(data, K_TIMEOUT_ABS_US(data->scan_time_us));
 #endif
 }
 
-static int kscan_matrix_read(const struct device *dev) {
+static void kscan_matrix_send(const struct device *dev, const int row, const int col,
+                              const bool pressed) {
+    const struct kscan_matrix_data *data = dev->data;
+
+    LOG_DBG("Sending event at %i,%i state %s", row, col, pressed ? "on" : "off");
+    data->callback(dev, row, col, pressed);
+}
+
+static void kscan_matrix_report(const struct device *dev, const int row, const int col,
+                                const bool pressed) {
     struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
 
-    // Scan the matrix.
+    if (!config->ghost_detection) {
+        kscan_matrix_send(dev, row, col, pressed);
+        return;
+    }
+
+    // Sent by kscan_matrix_resolve_ghosts() once the key can't be a ghost.
+    const int output_idx = (config->diode_direction == KSCAN_ROW2COL) ? row : col;
+    const int input_idx = (config->diode_direction == KSCAN_ROW2COL) ? col : row;
+
+    WRITE_BIT(data->pressed_inputs[output_idx], input_idx, pressed);
+    data->pressed_inputs_changed = true;
+}
+
+/**
+ * Send the key changes recorded by kscan_matrix_report(), deferring presses which could be ghosts
+ * until they no longer are. Releases are sent right away.
+ */
+static void kscan_matrix_resolve_ghosts(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+
+    if (!data->pressed_inputs_changed) {
+        return;
+    }
+
+    data->pressed_inputs_changed = false;
+
     for (int i = 0; i < config->outputs.len; i++) {
-        const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
+        const uint32_t pressed = data->pressed_inputs[i];
+        const uint32_t reported = data->reported_inputs[i];
+        const uint32_t ghosts =
+            zmk_kscan_ghost_inputs(data->pressed_inputs, config->outputs.len, i);
 
-        int err = gpio_pin_set_dt(&out_gpio->spec, 1);
-        if (err) {
-            LOG_ERR("Failed to set output %i active: %i", out_gpio->index, err);
-            return err;
-        }
+        uint32_t changed = (reported & ~pressed) | (pressed & ~reported & ~ghosts);
+        data->reported_inputs[i] ^= changed;
 
-#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS > 0
-        k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS);
-#endif
-        struct kscan_gpio_port_state state = {0};
+        while (changed) {
+            const int input_idx = u32_count_trailing_zeros(changed);
+            const bool input_pressed = pressed & BIT(input_idx);
 
-        for (int j = 0; j < data->inputs.len; j++) {
-            const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
+            changed &= ~BIT(input_idx);
 
-            const int index = state_index_io(config, in_gpio->index, out_gpio->index);
-            const int active = kscan_gpio_pin_get(in_gpio, &state);
-            if (active < 0) {
-                LOG_ERR("Failed to read port %s: %i", in_gpio->spec.port->name, active);
-                return active;
+            if (config->diode_direction == KSCAN_ROW2COL) {
+                kscan_matrix_send(dev, i, input_idx, input_pressed);
+            } else {
+                kscan_matrix_send(dev, input_idx, i, input_pressed);
             }
+        }
+    }
+}
+
+static int kscan_matrix_read_inputs(const struct device *dev, const struct kscan_gpio *out_gpio,
+                                    const int elapsed_ms, bool *any_input_active) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+    struct kscan_gpio_port_state state = {0};
+
+    for (int j = 0; j < data->inputs.len; j++) {
+        const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
 
-            zmk_debounce_update(&data->matrix_state[index], active, config->debounce_scan_period_ms,
-                                &config->debounce_config);
+        const int index = state_index_io(config, in_gpio->index, out_gpio->index);
+        const int active = kscan_gpio_pin_get(in_gpio, &state);
+        if (active < 0) {
+            LOG_ERR("Failed to read port %s: %i", in_gpio->spec.port->name, active);
+            return active;
         }
 
-        err = gpio_pin_set_dt(&out_gpio->spec, 0);
-        if (err) {
-            LOG_ERR("Failed to set output %i inactive: %i", out_gpio->index, err);
-            return err;
+        *any_input_active = *any_input_active || active;
+
+        struct zmk_debounce_state *deb_state = &data->matrix_state[index];
+        zmk_debounce_update(deb_state, active, elapsed_ms, &config->debounce_config);
+
+        if (zmk_debounce_is_active(deb_state) || zmk_debounce_get_changed(deb_state)) {
+            data->active_cells[index / 32] |= BIT(index % 32);
         }
+    }
 
-#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
-        k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
-#endif
+    return 0;
+}
+
+/**
+ * Read all inputs with a single port read and debounce them together.
+ */
+static int kscan_matrix_read_inputs_port(const struct device *dev, const int output_idx,
+                                         bool *any_input_active) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct device *port = data->inputs.gpios[0].spec.port;
+    gpio_port_value_t value;
+
+    const int err = gpio_port_get(port, &value);
+    if (err) {
+        LOG_ERR("Failed to read port %s: %i", port->name, err);
+        return err;
     }
 
-    // Process the new state.
-    bool continue_scan = false;
+    value &= data->port_inputs;
+    *any_input_active = *any_input_active || value;
+
+    zmk_debounce_vertical_update(&data->port_state[output_idx], value,
+                                 &data->port_debounce_config);
+
+    return 0;
+}
+
+/**
+ * Report changed keys from matrix_state, visiting only the cells in active_cells.
+ *
+ * @returns whether any key is pressed or still being debounced.
+ */
+static bool kscan_matrix_process_state(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+    const int words = DIV_ROUND_UP(config->rows * config->cols, 32);
+    uint32_t any_cell_active = 0;
 
-    for (int r = 0; r < config->rows; r++) {
-        for (int c = 0; c < config->cols; c++) {
-            const int index = state_index_rc(config, r, c);
-            struct zmk_debounce_state *state = &data->matrix_state[index];
+    for (int i = 0; i < words; i++) {
+        uint32_t cells = data->active_cells[i];
+
+        while (cells) {
+            const int bit = u32_count_trailing_zeros(cells);
+            const int index = i * 32 + bit;
+            const struct zmk_debounce_state *state = &data->matrix_state[index];
+
+            cells &= ~BIT(bit);
 
             if (zmk_debounce_get_changed(state)) {
-                const bool pressed = zmk_debounce_is_pressed(state);
+                // Inverse of state_index_rc().
+                kscan_matrix_report(dev, index % config->rows, index / config->rows,
+                                    zmk_debounce_is_pressed(state));
+            }
 
-                LOG_DBG("Sending event at %i,%i state %s", r, c, pressed ? "on" : "off");
-                data->callback(dev, r, c, pressed);
+            // Released cells only needed reporting. They're tracked again once they become active.
+            if (!zmk_debounce_is_active(state)) {
+                data->active_cells[i] &= ~BIT(bit);
             }
+        }
+
+        any_cell_active |= data->active_cells[i];
+    }
+
+    return any_cell_active != 0;
+}
 
-            continue_scan = continue_scan || zmk_debounce_is_active(state);
+/**
+ * Report changed keys from port_state.
+ *
+ * Keys are reported in output-major order: every changed key on the first output, then the next
+ * output, and so on. kscan_matrix_process_state() reports in column-major order instead, so with
+ * row2col diodes, keys which change in the same scan are reported in a different order depending
+ * on which of the two is used.
+ *
+ * @returns whether any key is pressed or still being debounced.
+ */
+static bool kscan_matrix_process_port_state(const struct device *dev) {
+    const struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+    bool any_key_active = false;
+
+    for (int i = 0; i < config->outputs.len; i++) {
+        const struct zmk_debounce_vertical_state *state = &data->port_state[i];
+        const int output_idx = config->outputs.gpios[i].index;
+
+        for (int j = 0; state->changed && j < data->inputs.len; j++) {
+            const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
+            const uint32_t pin_bit = BIT(in_gpio->spec.pin);
+
+            if (state->changed & pin_bit) {
+                const bool pressed = state->pressed & pin_bit;
+
+                if (config->diode_direction == KSCAN_ROW2COL) {
+                    kscan_matrix_report(dev, output_idx, in_gpio->index, pressed);
+                } else {
+                    kscan_matrix_report(dev, in_gpio->index, output_idx, pressed);
+                }
+            }
         }
+
+        any_key_active = any_key_active ||
+                         zmk_debounce_vertical_get_active(state, &data->port_debounce_config);
     }
 
+    return any_key_active;
+}
+
+static int kscan_matrix_read(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+
+    // The debouncer counts whole milliseconds, so when ZMK_KSCAN_MATRIX_SCAN_PERIOD_US scans
+    // faster than that, carry the remainder over to the next scan.
+    data->debounce_elapsed_us += config->debounce_scan_period_us;
+    const int elapsed_ms = data->debounce_elapsed_us / USEC_PER_MSEC;
+    data->debounce_elapsed_us %= USEC_PER_MSEC;
+
+    // Keep scanning quickly while any input reads active, even if the
+    // debouncer has not accumulated enough time to start counting it yet.
+    bool any_input_active = false;
+
+    // Scan the matrix.
+    for (int i = 0; i < config->outputs.len; i++) {
+        const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
+        int err;
+
+        // Every later output is set active by kscan_matrix_next_output().
+        if (i == 0) {
+            err = gpio_pin_set_dt(&out_gpio->spec, 1);
+            if (err) {
+                LOG_ERR("Failed to set output %i active: %i", out_gpio->index, err);
+                return err;
+            }
+        }
+
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS > 0
+        k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS);
+#endif
+        err = config->scan_port
+                  ? kscan_matrix_read_inputs_port(dev, i, &any_input_active)
+                  : kscan_matrix_read_inputs(dev, out_gpio, elapsed_ms, &any_input_active);
+        if (err) {
+            return err;
+        }
+
+        err = kscan_matrix_next_output(dev, i);
+        if (err) {
+            return err;
+        }
+    }
+
+    // Process the new state.
+    const bool any_key_active =
+        config->scan_port ? kscan_matrix_process_port_state(dev) : kscan_matrix_process_state(dev);
+
+    if (config->ghost_detection) {
+        kscan_matrix_resolve_ghosts(dev);
+    }
+    const bool continue_scan = any_input_active || any_key_active;
+
     if (continue_scan) {
         // At least one key is pressed or the debouncer has not yet decided if
         // it is pressed. Poll quickly until everything is released.
@@ -290,9 +638,34 @@ static int kscan_matrix_read(const struct device *dev) {
     return 0;
 }
 
+#if USE_SCAN_STATS
+static void kscan_matrix_record_jitter(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+    struct kscan_matrix_scan_stats *stats = &data->scan_stats;
+
+    const uint32_t jitter_us = MAX(kscan_matrix_uptime_us() - data->scan_time_us, 0);
+
+    int bucket = 0;
+    while (bucket < SCAN_JITTER_BUCKETS - 1 && jitter_us >= (SCAN_JITTER_BUCKET_MIN_US << bucket)) {
+        bucket++;
+    }
+
+    stats->jitter_histogram[bucket]++;
+    stats->max_jitter_us = MAX(stats->max_jitter_us, jitter_us);
+
+    if (jitter_us >= config->debounce_scan_period_us) {
+        stats->overruns++;
+    }
+}
+#endif
+
 static void kscan_matrix_work_handler(struct k_work *work) {
     struct k_work_delayable *dwork = k_work_delayable_from_work(work);
     struct kscan_matrix_data *data = CONTAINER_OF(dwork, struct kscan_matrix_data, work);
+#if USE_SCAN_STATS
+    kscan_matrix_record_jitter(data->dev);
+#endif
     kscan_matrix_read(data->dev);
 }
 
@@ -310,7 +683,7 @@ static int kscan_matrix_configure(const struct device *dev, const kscan_callback
 static int kscan_matrix_enable(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
 
-    data->scan_time = k_uptime_get();
+    data->scan_time_us = kscan_matrix_uptime_us();
 
     // Read will automatically start interrupts/polling once done.
     return kscan_matrix_read(dev);
@@ -443,6 +816,32 @@ static void kscan_matrix_setup_pins(const struct device *dev) {
     kscan_matrix_set_all_outputs(dev, 0);
 }
 
+static void kscan_matrix_init_scan_port(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+    const struct kscan_matrix_config *config = dev->config;
+
+    if (!config->scan_port) {
+        LOG_DBG("Reading inputs one at a time");
+        return;
+    }
+
+    const uint32_t scan_period_us = config->debounce_scan_period_us;
+    const uint32_t press_scans =
+        DIV_ROUND_UP(config->debounce_config.debounce_press_ms * USEC_PER_MSEC, scan_period_us);
+    const uint32_t release_scans =
+        DIV_ROUND_UP(config->debounce_config.debounce_release_ms * USEC_PER_MSEC, scan_period_us);
+
+    int err = zmk_debounce_vertical_config_init(&data->port_debounce_config, press_scans,
+                                                release_scans, config->debounce_config.eager_press);
+    __ASSERT(err == 0, "Debounce times don't fit the vertical debouncer: %d", err);
+    ARG_UNUSED(err);
+
+    data->port_inputs = 0;
+    for (int i = 0; i < data->inputs.len; i++) {
+        data->port_inputs |= BIT(data->inputs.gpios[i].spec.pin);
+    }
+}
+
 static int kscan_matrix_init(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
 
@@ -450,6 +849,7 @@ static int kscan_matrix_init(const struct device *dev) {
 
     // Sort inputs by port so we can read each port just once per scan.
     kscan_gpio_list_sort_by_port(&data->inputs);
+    kscan_matrix_init_scan_port(dev);
 
     k_work_init_delayable(&data->work, kscan_matrix_work_handler);
 
@@ -497,6 +897,8 @@ static const struct kscan_driver_api kscan_matrix_api = {
                  "ZMK_KSCAN_DEBOUNCE_PRESS_MS or debounce-press-ms is too large");                 \
     BUILD_ASSERT(INST_DEBOUNCE_RELEASE_MS(n) <= DEBOUNCE_COUNTER_MAX,                              \
                  "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
+    BUILD_ASSERT(!DT_INST_PROP(n, ghost_detection) || INST_INPUTS_LEN(n) <= 32,                    \
+                 "ghost-detection supports at most 32 inputs");                                    \
                                                                                                    \
     static struct kscan_gpio kscan_matrix_rows_##n[] = {                                           \
         LISTIFY(INST_ROWS_LEN(n), KSCAN_GPIO_ROW_CFG_INIT, (, ), n)};                              \
@@ -504,7 +906,18 @@ static const struct kscan_driver_api kscan_matrix_api = {
     static struct kscan_gpio kscan_matrix_cols_##n[] = {                                           \
         LISTIFY(INST_COLS_LEN(n), KSCAN_GPIO_COL_CFG_INIT, (, ), n)};                              \
                                                                                                    \
-    static struct zmk_debounce_state kscan_matrix_state_##n[INST_MATRIX_LEN(n)];                   \
+    /* Only the debounce state of the scan mode chosen at build time is allocated. */              \
+    static struct zmk_debounce_state                                                               \
+        kscan_matrix_state_##n[INST_SCAN_PORT(n) ? 0 : INST_MATRIX_LEN(n)];                        \
+    static uint32_t                                                                                \
+        kscan_matrix_active_cells_##n[INST_SCAN_PORT(n) ? 0 : INST_ACTIVE_CELLS_LEN(n)];           \
+    static struct zmk_debounce_vertical_state                                                      \
+        kscan_matrix_port_state_##n[INST_SCAN_PORT(n) ? INST_OUTPUTS_LEN(n) : 0];                  \
+                                                                                                   \
+    COND_CODE_1(DT_INST_PROP(n, ghost_detection),                                                  \
+                (static uint32_t kscan_matrix_pressed_inputs_##n[INST_OUTPUTS_LEN(n)];             \
+                 static uint32_t kscan_matrix_reported_inputs_##n[INST_OUTPUTS_LEN(n)];),          \
+                ())                                                                                \
                                                                                                    \
     COND_INTERRUPTS(                                                                               \
         (static struct kscan_matrix_irq_callback kscan_matrix_irqs_##n[INST_INPUTS_LEN(n)];))      \
@@ -513,6 +926,12 @@ static const struct kscan_driver_api kscan_matrix_api = {
         .inputs =                                                                                  \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_cols_##n), (kscan_matrix_rows_##n))),  \
         .matrix_state = kscan_matrix_state_##n,                                                    \
+        .active_cells = kscan_matrix_active_cells_##n,                                             \
+        .port_state = kscan_matrix_port_state_##n,                                                 \
+        COND_CODE_1(DT_INST_PROP(n, ghost_detection),                                              \
+                    (.pressed_inputs = kscan_matrix_pressed_inputs_##n,                            \
+                     .reported_inputs = kscan_matrix_reported_inputs_##n, ),                       \
+                    ())                                                                            \
         COND_INTERRUPTS((.irqs = kscan_matrix_irqs_##n, ))};                                       \
                                                                                                    \
     static struct kscan_matrix_config kscan_matrix_config_##n = {                                  \
@@ -524,10 +943,13 @@ static const struct kscan_driver_api kscan_matrix_api = {
             {                                                                                      \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .eager_press = DT_INST_PROP(n, debounce_eager_press),                              \
             },                                                                                     \
-        .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .debounce_scan_period_us = INST_SCAN_PERIOD_US(n),                                         \
         .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
         .diode_direction = INST_DIODE_DIR(n),                                                      \
+        .ghost_detection = DT_INST_PROP(n, ghost_detection),                                       \
+        .scan_port = INST_SCAN_PORT(n),                                                            \
     };                                                                                             \
                                                                                                    \
     PM_DEVICE_DT_INST_DEFINE(n, kscan_matrix_pm_action);                                           \
@@ -537,3 +959,49 @@ static const struct kscan_driver_api kscan_matrix_api = {
                           &kscan_matrix_api);
 
 DT_INST_FOREACH_STATUS_OKAY(KSCAN_MATRIX_INIT);
+
+#if USE_SCAN_STATS_SHELL
+
+#define KSCAN_MATRIX_DEVICE(n) DEVICE_DT_INST_GET(n),
+
+static const struct device *const kscan_matrix_devices[] = {
+    DT_INST_FOREACH_STATUS_OKAY(KSCAN_MATRIX_DEVICE)};
+
+static int kscan_matrix_cmd_stats(const struct shell *sh, size_t argc, char **argv) {
+    for (int i = 0; i < ARRAY_SIZE(kscan_matrix_devices); i++) {
+        const struct device *dev = kscan_matrix_devices[i];
+        const struct kscan_matrix_data *data = dev->data;
+        const struct kscan_matrix_scan_stats *stats = &data->scan_stats;
+
+        shell_print(sh, "%s: %u overruns, max jitter %u us", dev->name, stats->overruns,
+                    stats->max_jitter_us);
+
+        for (int j = 0; j < SCAN_JITTER_BUCKETS - 1; j++) {
+            shell_print(sh, "  < %5u us: %u", SCAN_JITTER_BUCKET_MIN_US << j,
+                        stats->jitter_histogram[j]);
+        }
+        shell_print(sh, "  >= %4u us: %u", SCAN_JITTER_BUCKET_MIN_US << (SCAN_JITTER_BUCKETS - 2),
+                    stats->jitter_histogram[SCAN_JITTER_BUCKETS - 1]);
+    }
+
+    return 0;
+}
+
+static int kscan_matrix_cmd_reset(const struct shell *sh, size_t argc, char **argv) {
+    for (int i = 0; i < ARRAY_SIZE(kscan_matrix_devices); i++) {
+        struct kscan_matrix_data *data = kscan_matrix_devices[i]->data;
+        data->scan_stats = (struct kscan_matrix_scan_stats){0};
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    kscan_matrix_cmds,
+    SHELL_CMD(stats, NULL, "Print matrix scan jitter statistics", kscan_matrix_cmd_stats),
+    SHELL_CMD(reset, NULL, "Reset matrix scan jitter statistics", kscan_matrix_cmd_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(kscan_matrix, &kscan_matrix_cmds, "Matrix kscan driver commands", NULL);
+
+#endif // USE_SCAN_STATS_SHELL
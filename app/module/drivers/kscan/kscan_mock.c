@@ -65,6 +65,14 @@ static int kscan_mock_configure(const struct device *dev, kscan_callback_t callb
         struct k_work_delayable *d_work = k_work_delayable_from_work(work);                        \
         struct kscan_mock_data *data = CONTAINER_OF(d_work, struct kscan_mock_data, work);         \
         const struct kscan_mock_config_##n *cfg = data->dev->config;                               \
+        if (data->event_index >= DT_INST_PROP_LEN(n, events)) {                                    \
+            /* The last event was followed by its own delay, there's nothing left to report. */   \
+            if (cfg->exit_after) {                                                                 \
+                LOG_DBG("Exiting");                                                                \
+                exit(0);                                                                           \
+            }                                                                                      \
+            return;                                                                                \
+        }                                                                                          \
         uint32_t ev = cfg->events[data->event_index];                                              \
         LOG_DBG("ev %u row %d column %d state %d\n", ev, ZMK_MOCK_ROW(ev), ZMK_MOCK_COL(ev),       \
                 ZMK_MOCK_IS_PRESS(ev));                                                            \
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file Keyboard scan driver which reads its inputs from a chain of 74HC165 style parallel-in,
+ * serial-out shift registers over SPI.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/debounce.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define DT_DRV_COMPAT zmk_kscan_shift_register
+
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
+#define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
+#else
+#define INST_DEBOUNCE_PRESS_MS(n) DT_INST_PROP(n, debounce_press_ms)
+#endif
+
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS >= 0
+#define INST_DEBOUNCE_RELEASE_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS
+#else
+#define INST_DEBOUNCE_RELEASE_MS(n) DT_INST_PROP(n, debounce_release_ms)
+#endif
+
+// The vertical debouncer counts scans instead of milliseconds.
+#define INST_DEBOUNCE_PRESS_SCANS(n)                                                               \
+    DIV_ROUND_UP(INST_DEBOUNCE_PRESS_MS(n), DT_INST_PROP(n, debounce_scan_period_ms))
+#define INST_DEBOUNCE_RELEASE_SCANS(n)                                                             \
+    DIV_ROUND_UP(INST_DEBOUNCE_RELEASE_MS(n), DT_INST_PROP(n, debounce_scan_period_ms))
+
+#define INST_ROWS_LEN(n) DT_INST_PROP_LEN_OR(n, row_gpios, 0)
+#define INST_INPUT_BYTES(n) (DT_INST_PROP(n, ngpios) / 8)
+#define INST_INPUT_WORDS(n) DIV_ROUND_UP(DT_INST_PROP(n, ngpios), 32)
+#define INST_STATE_LEN(n) (MAX(INST_ROWS_LEN(n), 1) * INST_INPUT_WORDS(n))
+
+#define KSCAN_SHIFT_REG_ROW_CFG_INIT(idx, inst_idx)                                                \
+    GPIO_DT_SPEC_INST_GET_BY_IDX(inst_idx, row_gpios, idx)
+
+struct kscan_shift_reg_data {
+    const struct device *dev;
+    kscan_callback_t callback;
+    struct k_work_delayable work;
+    /** Timestamp of the current or scheduled scan. */
+    int64_t scan_time;
+    /**
+     * Receive buffer for one burst read, padded to a whole number of 32-bit words so the unused
+     * bytes always read as zero.
+     */
+    uint8_t *rx_buf;
+    /**
+     * Debounce state of the inputs as an array of config->input_words words per row, with input
+     * i of a row in bit i % 32 of word i / 32.
+     */
+    struct zmk_debounce_vertical_state *state;
+    struct zmk_debounce_vertical_config debounce_config;
+};
+
+struct kscan_shift_reg_config {
+    struct spi_dt_spec bus;
+    struct gpio_dt_spec load_gpio;
+    const struct gpio_dt_spec *rows;
+    size_t rows_len;
+    size_t input_bytes;
+    size_t input_words;
+    uint32_t debounce_press_scans;
+    uint32_t debounce_release_scans;
+    int32_t debounce_scan_period_ms;
+    int32_t poll_period_ms;
+    bool debounce_eager_press;
+    bool active_low;
+};
+
+static size_t kscan_shift_reg_rows(const struct kscan_shift_reg_config *config) {
+    // Without row-gpios, every input is a key in row 0.
+    return MAX(config->rows_len, 1);
+}
+
+static int kscan_shift_reg_set_row(const struct device *dev, const int row, const int value) {
+    const struct kscan_shift_reg_config *config = dev->config;
+
+    if (config->rows_len == 0) {
+        return 0;
+    }
+
+    const int err = gpio_pin_set_dt(&config->rows[row], value);
+    if (err) {
+        LOG_ERR("Failed to set row %i %s: %i", row, value ? "active" : "inactive", err);
+    }
+
+    return err;
+}
+
+/**
+ * Latch the current level of every input into the shift registers.
+ */
+static int kscan_shift_reg_load(const struct device *dev) {
+    const struct kscan_shift_reg_config *config = dev->config;
+
+    int err = gpio_pin_set_dt(&config->load_gpio, 1);
+    if (err) {
+        return err;
+    }
+
+    return gpio_pin_set_dt(&config->load_gpio, 0);
+}
+
+/**
+ * Read every input of one row with a single SPI transfer and debounce them a word at a time.
+ */
+static int kscan_shift_reg_read_row(const struct device *dev, const int row,
+                                    bool *any_input_active) {
+    struct kscan_shift_reg_data *data = dev->data;
+    const struct kscan_shift_reg_config *config = dev->config;
+
+    int err = kscan_shift_reg_load(dev);
+    if (err) {
+        LOG_ERR("Failed to load inputs: %i", err);
+        return err;
+    }
+
+    const struct spi_buf rx_buf = {.buf = data->rx_buf, .len = config->input_bytes};
+    const struct spi_buf_set rx = {.buffers = &rx_buf, .count = 1};
+
+    err = spi_read_dt(&config->bus, &rx);
+    if (err) {
+        LOG_ERR("Failed to read inputs: %i", err);
+        return err;
+    }
+
+    // The first byte read comes from the register nearest the controller, and each byte holds
+    // inputs A-H of one register in bits 0-7, so the buffer is a little-endian bitmap of inputs.
+    for (int i = 0; i < config->input_words; i++) {
+        const size_t bytes = MIN(config->input_bytes - i * 4, 4);
+        uint32_t value = sys_get_le32(&data->rx_buf[i * 4]);
+
+        if (config->active_low) {
+            value = ~value & BIT64_MASK(bytes * 8);
+        }
+
+        *any_input_active = *any_input_active || value;
+
+        zmk_debounce_vertical_update(&data->state[row * config->input_words + i], value,
+                                     &data->debounce_config);
+    }
+
+    return 0;
+}
+
+/**
+ * Report changed keys.
+ *
+ * @returns whether any key is pressed or still being debounced.
+ */
+static bool kscan_shift_reg_process_state(const struct device *dev) {
+    const struct kscan_shift_reg_data *data = dev->data;
+    const struct kscan_shift_reg_config *config = dev->config;
+    bool any_key_active = false;
+
+    for (int row = 0; row < kscan_shift_reg_rows(config); row++) {
+        for (int i = 0; i < config->input_words; i++) {
+            const struct zmk_debounce_vertical_state *state =
+                &data->state[row * config->input_words + i];
+            uint32_t changed = state->changed;
+
+            while (changed) {
+                const int bit = u32_count_trailing_zeros(changed);
+                const int column = i * 32 + bit;
+                const bool pressed = state->pressed & BIT(bit);
+
+                changed &= ~BIT(bit);
+
+                LOG_DBG("Sending event at %i,%i state %s", row, column, pressed ? "on" : "off");
+                data->callback(dev, row, column, pressed);
+            }
+
+            any_key_active = any_key_active ||
+                             zmk_debounce_vertical_get_active(state, &data->debounce_config);
+        }
+    }
+
+    return any_key_active;
+}
+
+static int kscan_shift_reg_read(const struct device *dev) {
+    struct kscan_shift_reg_data *data = dev->data;
+    const struct kscan_shift_reg_config *config = dev->config;
+
+    // Keep scanning quickly while any input reads active, even if the
+    // debouncer has not decided it is pressed yet.
+    bool any_input_active = false;
+
+    for (int row = 0; row < kscan_shift_reg_rows(config); row++) {
+        int err = kscan_shift_reg_set_row(dev, row, 1);
+        if (err) {
+            return err;
+        }
+
+        err = kscan_shift_reg_read_row(dev, row, &any_input_active);
+        if (err) {
+            return err;
+        }
+
+        err = kscan_shift_reg_set_row(dev, row, 0);
+        if (err) {
+            return err;
+        }
+    }
+
+    const bool any_key_active = kscan_shift_reg_process_state(dev);
+
+    if (any_input_active || any_key_active) {
+        // At least one key is pressed or the debouncer has not yet decided if
+        // it is pressed. Poll quickly until everything is released.
+        data->scan_time += config->debounce_scan_period_ms;
+    } else {
+        // All keys are released. Return to polling slowly.
+        data->scan_time += config->poll_period_ms;
+    }
+
+    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+
+    return 0;
+}
+
+static void kscan_shift_reg_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = CONTAINER_OF(work, struct k_work_delayable, work);
+    struct kscan_shift_reg_data *data = CONTAINER_OF(dwork, struct kscan_shift_reg_data, work);
+    kscan_shift_reg_read(data->dev);
+}
+
+static int kscan_shift_reg_configure(const struct device *dev, kscan_callback_t callback) {
+    struct kscan_shift_reg_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->callback = callback;
+    return 0;
+}
+
+static int kscan_shift_reg_enable(const struct device *dev) {
+    struct kscan_shift_reg_data *data = dev->data;
+
+    data->scan_time = k_uptime_get();
+
+    // Read will automatically start polling once done.
+    return kscan_shift_reg_read(dev);
+}
+
+static int kscan_shift_reg_disable(const struct device *dev) {
+    struct kscan_shift_reg_data *data = dev->data;
+
+    k_work_cancel_delayable(&data->work);
+    return 0;
+}
+
+static int kscan_shift_reg_init_pin(const struct gpio_dt_spec *gpio, const gpio_flags_t flags) {
+    if (!gpio_is_ready_dt(gpio)) {
+        LOG_ERR("GPIO is not ready: %s", gpio->port->name);
+        return -ENODEV;
+    }
+
+    const int err = gpio_pin_configure_dt(gpio, flags);
+    if (err) {
+        LOG_ERR("Unable to configure pin %u on %s", gpio->pin, gpio->port->name);
+    }
+
+    return err;
+}
+
+static int kscan_shift_reg_init(const struct device *dev) {
+    struct kscan_shift_reg_data *data = dev->data;
+    const struct kscan_shift_reg_config *config = dev->config;
+
+    data->dev = dev;
+
+    if (!spi_is_ready_dt(&config->bus)) {
+        LOG_ERR("SPI bus %s is not ready", config->bus.bus->name);
+        return -ENODEV;
+    }
+
+    int err = kscan_shift_reg_init_pin(&config->load_gpio, GPIO_OUTPUT_INACTIVE);
+    if (err) {
+        return err;
+    }
+
+    for (int i = 0; i < config->rows_len; i++) {
+        err = kscan_shift_reg_init_pin(&config->rows[i], GPIO_OUTPUT_INACTIVE);
+        if (err) {
+            return err;
+        }
+    }
+
+    err = zmk_debounce_vertical_config_init(&data->debounce_config, config->debounce_press_scans,
+                                            config->debounce_release_scans,
+                                            config->debounce_eager_press);
+    if (err) {
+        LOG_ERR("Debounce times are too long for the scan period");
+        return err;
+    }
+
+    k_work_init_delayable(&data->work, kscan_shift_reg_work_handler);
+
+#if IS_ENABLED(CONFIG_PM_DEVICE)
+    pm_device_init_suspended(dev);
+
+#if IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME)
+    pm_device_runtime_enable(dev);
+#endif
+
+#endif
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_PM_DEVICE)
+
+static int kscan_shift_reg_pm_action(const struct device *dev, enum pm_device_action action) {
+    switch (action) {
+    case PM_DEVICE_ACTION_SUSPEND:
+        return kscan_shift_reg_disable(dev);
+    case PM_DEVICE_ACTION_RESUME:
+        return kscan_shift_reg_enable(dev);
+    default:
+        return -ENOTSUP;
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_PM_DEVICE)
+
+static const struct kscan_driver_api kscan_shift_reg_api = {
+    .config = kscan_shift_reg_configure,
+    .enable_callback = kscan_shift_reg_enable,
+    .disable_callback = kscan_shift_reg_disable,
+};
+
+#define KSCAN_SHIFT_REG_INIT(n)                                                                    \
+    BUILD_ASSERT(DT_INST_PROP(n, ngpios) % 8 == 0, "ngpios must be a multiple of 8");              \
+    BUILD_ASSERT(INST_DEBOUNCE_PRESS_SCANS(n) <= DEBOUNCE_VERTICAL_COUNTER_MAX,                    \
+                 "ZMK_KSCAN_DEBOUNCE_PRESS_MS or debounce-press-ms is too large");                 \
+    BUILD_ASSERT(INST_DEBOUNCE_RELEASE_SCANS(n) <= DEBOUNCE_VERTICAL_COUNTER_MAX,                  \
+                 "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
+                                                                                                   \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(n, row_gpios),                                               \
+                (static const struct gpio_dt_spec kscan_shift_reg_rows_##n[] = {                   \
+                     LISTIFY(INST_ROWS_LEN(n), KSCAN_SHIFT_REG_ROW_CFG_INIT, (, ), n)};),          \
+                ())                                                                                \
+                                                                                                   \
+    static uint8_t kscan_shift_reg_rx_buf_##n[INST_INPUT_WORDS(n) * 4];                            \
+    static struct zmk_debounce_vertical_state kscan_shift_reg_state_##n[INST_STATE_LEN(n)];        \
+                                                                                                   \
+    static struct kscan_shift_reg_data kscan_shift_reg_data_##n = {                                \
+        .rx_buf = kscan_shift_reg_rx_buf_##n,                                                      \
+        .state = kscan_shift_reg_state_##n,                                                        \
+    };                                                                                             \
+                                                                                                   \
+    static const struct kscan_shift_reg_config kscan_shift_reg_config_##n = {                      \
+        .bus = SPI_DT_SPEC_INST_GET(n, SPI_OP_MODE_MASTER | SPI_WORD_SET(8), 0),                   \
+        .load_gpio = GPIO_DT_SPEC_INST_GET(n, load_gpios),                                         \
+        .rows = COND_CODE_1(DT_INST_NODE_HAS_PROP(n, row_gpios), (kscan_shift_reg_rows_##n),       \
+                            (NULL)),                                                               \
+        .rows_len = INST_ROWS_LEN(n),                                                              \
+        .input_bytes = INST_INPUT_BYTES(n),                                                        \
+        .input_words = INST_INPUT_WORDS(n),                                                        \
+        .debounce_press_scans = INST_DEBOUNCE_PRESS_SCANS(n),                                      \
+        .debounce_release_scans = INST_DEBOUNCE_RELEASE_SCANS(n),                                  \
+        .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
+        .debounce_eager_press = DT_INST_PROP(n, debounce_eager_press),                             \
+        .active_low = DT_INST_PROP(n, active_low),                                                 \
+    };                                                                                             \
+                                                                                                   \
+    PM_DEVICE_DT_INST_DEFINE(n, kscan_shift_reg_pm_action);                                        \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, &kscan_shift_reg_init, PM_DEVICE_DT_INST_GET(n),                      \
+                          &kscan_shift_reg_data_##n, &kscan_shift_reg_config_##n, POST_KERNEL,     \
+                          CONFIG_KSCAN_INIT_PRIORITY, &kscan_shift_reg_api);
+
+DT_INST_FOREACH_STATUS_OKAY(KSCAN_SHIFT_REG_INIT);
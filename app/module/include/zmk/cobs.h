@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Consistent Overhead Byte Stuffing replaces every zero byte of the data, so that zero bytes can
+ * delimit frames on a serial line. Encoding adds one byte, plus one for every 254 bytes of data.
+ */
+#define ZMK_COBS_ENCODED_MAX_LEN(len) ((len) + (len) / 254 + 1)
+
+#define ZMK_COBS_FRAME_CRC_LEN 2
+
+/**
+ * Maximum length of a frame holding `len` bytes of data, including the CRC and zero delimiter.
+ */
+#define ZMK_COBS_FRAME_MAX_LEN(len) (ZMK_COBS_ENCODED_MAX_LEN((len) + ZMK_COBS_FRAME_CRC_LEN) + 1)
+
+/**
+ * COBS encodes data.
+ *
+ * @param src The data to encode.
+ * @param len The length of the data.
+ * @param dst Receives the encoded data, which never contains a zero byte. Must hold at least
+ * ZMK_COBS_ENCODED_MAX_LEN(len) bytes and not overlap src.
+ * @return The length of the encoded data.
+ */
+size_t zmk_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * Decodes COBS encoded data. Decoding never writes past the byte being read, so dst may be the
+ * same buffer as src.
+ *
+ * @param src The encoded data, without a zero delimiter.
+ * @param len The length of the encoded data.
+ * @param dst Receives the decoded data. Must hold at least len bytes.
+ * @return The length of the decoded data, or -EINVAL if src is not valid COBS encoded data.
+ */
+int zmk_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * Encodes data as a frame: the COBS encoded data followed by its little-endian CRC16-CCITT, and a
+ * zero delimiter.
+ *
+ * @param data The data to send.
+ * @param len The length of the data.
+ * @param frame Receives the frame. Must hold at least ZMK_COBS_FRAME_MAX_LEN(len) bytes.
+ * @return The length of the frame, including the delimiter.
+ */
+size_t zmk_cobs_frame_encode(const uint8_t *data, size_t len, uint8_t *frame);
+
+/**
+ * Decodes a frame in place and checks its CRC.
+ *
+ * @param frame The bytes received between two zero delimiters. Receives the data.
+ * @param len The number of bytes received.
+ * @return The length of the data, -EINVAL if the frame is not valid COBS encoded data, or -EBADMSG
+ * if it is too short to hold a CRC or the CRC doesn't match.
+ */
+int zmk_cobs_frame_decode(uint8_t *frame, size_t len);
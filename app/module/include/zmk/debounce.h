@@ -16,14 +16,21 @@
 struct zmk_debounce_state {
     bool pressed : 1;
     bool changed : 1;
+    /** Switch is ignored until the counter runs out after an eager press. */
+    bool locked : 1;
     uint16_t counter : DEBOUNCE_COUNTER_BITS;
 };
 
 struct zmk_debounce_config {
-    /** Duration a switch must be pressed to latch as pressed. */
+    /**
+     * Duration a switch must be pressed to latch as pressed. With eager_press, the duration a
+     * switch is ignored after latching as pressed instead.
+     */
     uint32_t debounce_press_ms;
     /** Duration a switch must be released to latch as released. */
     uint32_t debounce_release_ms;
+    /** Latch switches as pressed as soon as they read active. */
+    bool eager_press;
 };
 
 /**
@@ -54,3 +61,71 @@ bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state);
  * debounce_update.
  */
 bool zmk_debounce_get_changed(const struct zmk_debounce_state *state);
+
+#define DEBOUNCE_VERTICAL_COUNTER_BITS 8
+#define DEBOUNCE_VERTICAL_COUNTER_MAX BIT_MASK(DEBOUNCE_VERTICAL_COUNTER_BITS)
+
+/**
+ * Debounce state of up to 32 switches, one per bit, updated together.
+ *
+ * Each switch has the same integrating counter as struct zmk_debounce_state,
+ * but counting updates instead of milliseconds. The counters are stored as bit
+ * planes (a "vertical counter"), so updating every switch only takes a few
+ * word-wide operations per counter bit.
+ */
+struct zmk_debounce_vertical_state {
+    /** Switches latched as pressed. */
+    uint32_t pressed;
+    /** Switches whose pressed state changed in the last update. */
+    uint32_t changed;
+    /** Switches ignored until their counter runs out after an eager press. */
+    uint32_t locked;
+    /** Bit planes of the switch counters, least significant first. */
+    uint32_t counter[DEBOUNCE_VERTICAL_COUNTER_BITS];
+};
+
+struct zmk_debounce_vertical_config {
+    /**
+     * Number of updates a switch must be pressed to latch as pressed. With eager_press, the number
+     * of updates a switch is ignored after latching as pressed instead.
+     */
+    uint8_t debounce_press_updates;
+    /** Number of updates a switch must be released to latch as released. */
+    uint8_t debounce_release_updates;
+    /** Number of counter bit planes needed to count up to both thresholds. */
+    uint8_t counter_bits;
+    /** Latch switches as pressed as soon as they read active. */
+    bool eager_press;
+};
+
+/**
+ * Initializes a vertical debounce config.
+ *
+ * @param config The config to initialize.
+ * @param debounce_press_updates Updates a switch must be pressed to latch as pressed.
+ * @param debounce_release_updates Updates a switch must be released to latch as released.
+ * @param eager_press Latch switches as pressed as soon as they read active.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If a threshold is larger than DEBOUNCE_VERTICAL_COUNTER_MAX.
+ */
+int zmk_debounce_vertical_config_init(struct zmk_debounce_vertical_config *config,
+                                      uint32_t debounce_press_updates,
+                                      uint32_t debounce_release_updates, bool eager_press);
+
+/**
+ * Debounces up to 32 switches at once.
+ *
+ * @param state The state for the switches to debounce.
+ * @param active Bitmask of the switches currently pressed.
+ * @param config Debounce settings.
+ */
+void zmk_debounce_vertical_update(struct zmk_debounce_vertical_state *state, const uint32_t active,
+                                  const struct zmk_debounce_vertical_config *config);
+
+/**
+ * @returns a bitmask of the switches which are either latched as pressed or
+ * potentially pressed but not yet decided by the debouncer.
+ */
+uint32_t zmk_debounce_vertical_get_active(const struct zmk_debounce_vertical_state *state,
+                                          const struct zmk_debounce_vertical_config *config);
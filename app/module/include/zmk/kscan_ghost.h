@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Get the inputs of an output which could be ghosts.
+ *
+ * Without diodes, current can flow backwards through pressed keys. When two outputs each have the
+ * same two or more inputs pressed, any one key of such a rectangle reads as pressed as long as the
+ * other three are, so none of them can be told apart from a ghost.
+ *
+ * @param pressed Bitmaps of the pressed inputs for each output.
+ * @param len Number of outputs.
+ * @param output_idx Output to get the ambiguous inputs of.
+ *
+ * @returns a bitmap of the pressed inputs of the output which are part of a rectangle.
+ */
+static inline uint32_t zmk_kscan_ghost_inputs(const uint32_t *pressed, const size_t len,
+                                              const int output_idx) {
+    const uint32_t inputs = pressed[output_idx];
+    uint32_t ghosts = 0;
+
+    // Clearing the lowest bit leaves zero unless at least two bits are set.
+    if ((inputs & (inputs - 1)) == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < len; i++) {
+        const uint32_t shared = inputs & pressed[i];
+
+        if (i != output_idx && (shared & (shared - 1)) != 0) {
+            ghosts |= shared;
+        }
+    }
+
+    return ghosts;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+
+#include <zmk/cobs.h>
+
+struct cobs_encoder {
+    uint8_t *dst;
+    // Index of the code byte for the block being encoded, filled in once the block ends.
+    size_t code_idx;
+    size_t out;
+    uint8_t code;
+};
+
+static void encoder_init(struct cobs_encoder *enc, uint8_t *dst) {
+    *enc = (struct cobs_encoder){.dst = dst, .code_idx = 0, .out = 1, .code = 1};
+}
+
+static void encoder_put(struct cobs_encoder *enc, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            enc->dst[enc->code_idx] = enc->code;
+            enc->code_idx = enc->out++;
+            enc->code = 1;
+            continue;
+        }
+
+        enc->dst[enc->out++] = src[i];
+        if (++enc->code == 0xFF) {
+            enc->dst[enc->code_idx] = enc->code;
+            enc->code_idx = enc->out++;
+            enc->code = 1;
+        }
+    }
+}
+
+static size_t encoder_finish(struct cobs_encoder *enc) {
+    enc->dst[enc->code_idx] = enc->code;
+    return enc->out;
+}
+
+size_t zmk_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    struct cobs_encoder enc;
+
+    encoder_init(&enc, dst);
+    encoder_put(&enc, src, len);
+    return encoder_finish(&enc);
+}
+
+int zmk_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t out = 0;
+
+    for (size_t i = 0; i < len;) {
+        uint8_t code = src[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return -EINVAL;
+        }
+
+        for (uint8_t j = 1; j < code; j++) {
+            dst[out++] = src[i++];
+        }
+
+        if (code != 0xFF && i < len) {
+            dst[out++] = 0;
+        }
+    }
+
+    return out;
+}
+
+size_t zmk_cobs_frame_encode(const uint8_t *data, size_t len, uint8_t *frame) {
+    struct cobs_encoder enc;
+    uint8_t crc[ZMK_COBS_FRAME_CRC_LEN];
+
+    sys_put_le16(crc16_ccitt(0xFFFF, data, len), crc);
+
+    encoder_init(&enc, frame);
+    encoder_put(&enc, data, len);
+    encoder_put(&enc, crc, sizeof(crc));
+
+    size_t frame_len = encoder_finish(&enc);
+    frame[frame_len++] = 0;
+
+    return frame_len;
+}
+
+int zmk_cobs_frame_decode(uint8_t *frame, size_t len) {
+    int decoded = zmk_cobs_decode(frame, len, frame);
+    if (decoded < 0) {
+        return decoded;
+    }
+
+    if (decoded < ZMK_COBS_FRAME_CRC_LEN) {
+        return -EBADMSG;
+    }
+
+    size_t data_len = decoded - ZMK_COBS_FRAME_CRC_LEN;
+    if (crc16_ccitt(0xFFFF, frame, data_len) != sys_get_le16(&frame[data_len])) {
+        return -EBADMSG;
+    }
+
+    return data_len;
+}
@@ -4,6 +4,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <errno.h>
+
+#include <zephyr/sys/math_extras.h>
+
 #include <zmk/debounce.h>
 
 static uint32_t get_threshold(const struct zmk_debounce_state *state,
@@ -36,6 +40,23 @@ void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, co
     // threshold, the state flips and we reset the counter.
     state->changed = false;
 
+    if (state->locked) {
+        // After an eager press, ignore the switch until the press debounce time has passed.
+        decrement_counter(state, elapsed_ms);
+        state->locked = state->counter > 0;
+        return;
+    }
+
+    if (config->eager_press && !state->pressed) {
+        if (active) {
+            state->pressed = true;
+            state->changed = true;
+            state->counter = config->debounce_press_ms;
+            state->locked = state->counter > 0;
+        }
+        return;
+    }
+
     if (active == state->pressed) {
         decrement_counter(state, elapsed_ms);
         return;
@@ -59,4 +80,112 @@ bool zmk_debounce_is_active(const struct zmk_debounce_state *state) {
 
 bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state) { return state->pressed; }
 
-bool zmk_debounce_get_changed(const struct zmk_debounce_state *state) { return state->changed; }
\ No newline at end of file
+bool zmk_debounce_get_changed(const struct zmk_debounce_state *state) { return state->changed; }
+
+int zmk_debounce_vertical_config_init(struct zmk_debounce_vertical_config *config,
+                                      uint32_t debounce_press_updates,
+                                      uint32_t debounce_release_updates, bool eager_press) {
+    const uint32_t max_updates = MAX(debounce_press_updates, debounce_release_updates);
+    if (max_updates > DEBOUNCE_VERTICAL_COUNTER_MAX) {
+        return -EINVAL;
+    }
+
+    config->debounce_press_updates = debounce_press_updates;
+    config->debounce_release_updates = debounce_release_updates;
+    config->eager_press = eager_press;
+    config->counter_bits = 32 - u32_count_leading_zeros(max_updates);
+    return 0;
+}
+
+// Each counter bit plane holds one bit of the counter of every switch, so the functions below
+// work like a ripple-carry adder running on all switches at once.
+
+static void vertical_increment(struct zmk_debounce_vertical_state *state, uint32_t mask,
+                               const struct zmk_debounce_vertical_config *config) {
+    for (int i = 0; i < config->counter_bits && mask; i++) {
+        const uint32_t carry = state->counter[i] & mask;
+        state->counter[i] ^= mask;
+        mask = carry;
+    }
+}
+
+static void vertical_decrement(struct zmk_debounce_vertical_state *state, uint32_t mask,
+                               const struct zmk_debounce_vertical_config *config) {
+    for (int i = 0; i < config->counter_bits && mask; i++) {
+        const uint32_t borrow = ~state->counter[i] & mask;
+        state->counter[i] ^= mask;
+        mask = borrow;
+    }
+}
+
+static uint32_t vertical_nonzero(const struct zmk_debounce_vertical_state *state,
+                                 const struct zmk_debounce_vertical_config *config) {
+    uint32_t nonzero = 0;
+
+    for (int i = 0; i < config->counter_bits; i++) {
+        nonzero |= state->counter[i];
+    }
+
+    return nonzero;
+}
+
+// Returns the switches whose counter reached the threshold for their current state.
+static uint32_t vertical_at_threshold(const struct zmk_debounce_vertical_state *state,
+                                      const struct zmk_debounce_vertical_config *config) {
+    uint32_t equal = UINT32_MAX;
+
+    for (int i = 0; i < config->counter_bits; i++) {
+        const uint32_t release_bit = config->debounce_release_updates & BIT(i) ? state->pressed : 0;
+        const uint32_t press_bit = config->debounce_press_updates & BIT(i) ? ~state->pressed : 0;
+
+        equal &= ~(state->counter[i] ^ (release_bit | press_bit));
+    }
+
+    return equal;
+}
+
+void zmk_debounce_vertical_update(struct zmk_debounce_vertical_state *state, const uint32_t active,
+                                  const struct zmk_debounce_vertical_config *config) {
+    // Same as zmk_debounce_update(), one update at a time. Counters never go past the threshold,
+    // so reaching it is the same as the scalar version's comparison.
+    const uint32_t locked = state->locked;
+
+    // Locked counters are never zero, so this only counts down the lockout.
+    vertical_decrement(state, locked, config);
+    state->locked &= vertical_nonzero(state, config);
+
+    uint32_t debounced = ~locked;
+    uint32_t eager = 0;
+
+    if (config->eager_press) {
+        eager = active & ~state->pressed;
+        debounced &= state->pressed;
+    }
+
+    const uint32_t mismatch = (active ^ state->pressed) & debounced;
+    const uint32_t flip = mismatch & vertical_at_threshold(state, config);
+
+    vertical_increment(state, mismatch & ~flip, config);
+    vertical_decrement(state, ~mismatch & debounced & vertical_nonzero(state, config), config);
+
+    for (int i = 0; i < config->counter_bits; i++) {
+        state->counter[i] &= ~flip;
+
+        // Released switches have a zero counter, so eager presses start their lockout from it.
+        if (config->debounce_press_updates & BIT(i)) {
+            state->counter[i] |= eager;
+        }
+    }
+
+    if (config->debounce_press_updates > 0) {
+        state->locked |= eager;
+    }
+
+    state->pressed = (state->pressed ^ flip) | eager;
+    state->changed = flip | eager;
+}
+
+uint32_t zmk_debounce_vertical_get_active(const struct zmk_debounce_vertical_state *state,
+                                          const struct zmk_debounce_vertical_config *config) {
+    return state->pressed | vertical_nonzero(state, config);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <time.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+#include "test_rand.h"
+
+// A 16x8 matrix with every input on the same port, as kscan_gpio_matrix scans it.
+#define OUTPUTS 8
+#define INPUTS 16
+#define INPUT_MASK BIT_MASK(INPUTS)
+
+#define SCANS 200000
+#define SCAN_PATTERNS 1024
+
+#define DEBOUNCE_PRESS_MS 5
+#define DEBOUNCE_RELEASE_MS 5
+
+static uint32_t scan_patterns[SCAN_PATTERNS];
+
+static struct zmk_debounce_state cell_states[OUTPUTS][INPUTS];
+static struct zmk_debounce_vertical_state port_states[OUTPUTS];
+
+// clock_gettime() comes from the host C library, so this is real time rather than the simulated
+// time which k_cycle_get_32() counts on native_posix.
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void *setup(void) {
+    test_rand_seed(0x2a2a2a2a);
+
+    // Few keys down at once, held over many scans, like typing.
+    for (int i = 0; i < SCAN_PATTERNS; i++) {
+        scan_patterns[i] = test_rand() & test_rand() & test_rand() & INPUT_MASK;
+    }
+
+    return NULL;
+}
+
+static uint32_t scan_inputs(int scan, int output) {
+    return scan_patterns[(scan / 16 + output) % SCAN_PATTERNS];
+}
+
+/**
+ * Debounces the same scans one switch at a time, like kscan_matrix_read_inputs(), and a port at a
+ * time, like kscan_matrix_read_inputs_port(), and prints the time per scan of each.
+ */
+ZTEST(zmk_debounce_benchmark, test_matrix_scan) {
+    const struct zmk_debounce_config config = {
+        .debounce_press_ms = DEBOUNCE_PRESS_MS,
+        .debounce_release_ms = DEBOUNCE_RELEASE_MS,
+    };
+    struct zmk_debounce_vertical_config vertical_config;
+    uint32_t cell_changes = 0;
+    uint32_t port_changes = 0;
+
+    zassert_ok(zmk_debounce_vertical_config_init(&vertical_config, DEBOUNCE_PRESS_MS,
+                                                 DEBOUNCE_RELEASE_MS, false));
+
+    const uint64_t cell_start = now_ns();
+
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (int o = 0; o < OUTPUTS; o++) {
+            const uint32_t inputs = scan_inputs(scan, o);
+
+            for (int i = 0; i < INPUTS; i++) {
+                struct zmk_debounce_state *state = &cell_states[o][i];
+
+                zmk_debounce_update(state, inputs & BIT(i), 1, &config);
+                cell_changes += zmk_debounce_get_changed(state);
+            }
+        }
+    }
+
+    const uint64_t port_start = now_ns();
+
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (int o = 0; o < OUTPUTS; o++) {
+            struct zmk_debounce_vertical_state *state = &port_states[o];
+
+            zmk_debounce_vertical_update(state, scan_inputs(scan, o), &vertical_config);
+            port_changes += __builtin_popcount(state->changed);
+        }
+    }
+
+    const uint64_t end = now_ns();
+
+    // Also keeps the compiler from dropping either loop.
+    zassert_equal(cell_changes, port_changes);
+
+    TC_PRINT("%dx%d matrix, %d scans, %u key changes\n", INPUTS, OUTPUTS, SCANS, cell_changes);
+    TC_PRINT("per switch: %u ns/scan\n", (uint32_t)((port_start - cell_start) / SCANS));
+    TC_PRINT("per port:   %u ns/scan\n", (uint32_t)((end - port_start) / SCANS));
+}
+
+ZTEST_SUITE(zmk_debounce_benchmark, NULL, setup, NULL, NULL, NULL);
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/ztest.h>
+
+#include <zmk/kscan_ghost.h>
+
+#include "test_rand.h"
+
+#define MAX_OUTPUTS 8
+#define MAX_INPUTS 32
+#define RANDOM_TRIALS 100000
+
+static bool is_pressed(const uint32_t *pressed, int output, int input) {
+    return pressed[output] & BIT(input);
+}
+
+/**
+ * Reference for zmk_kscan_ghost_inputs(): an input is a ghost if it is one corner of a rectangle of
+ * pressed keys, found by trying every other output and input as the opposite corner.
+ */
+static uint32_t brute_force_ghost_inputs(const uint32_t *pressed, size_t len, int inputs,
+                                         int output) {
+    uint32_t ghosts = 0;
+
+    for (int input = 0; input < inputs; input++) {
+        if (!is_pressed(pressed, output, input)) {
+            continue;
+        }
+
+        for (int other_output = 0; other_output < len; other_output++) {
+            for (int other_input = 0; other_input < inputs; other_input++) {
+                if (other_output != output && other_input != input &&
+                    is_pressed(pressed, output, other_input) &&
+                    is_pressed(pressed, other_output, input) &&
+                    is_pressed(pressed, other_output, other_input)) {
+                    ghosts |= BIT(input);
+                }
+            }
+        }
+    }
+
+    return ghosts;
+}
+
+static void assert_matches_brute_force(const uint32_t *pressed, size_t len, int inputs) {
+    for (int output = 0; output < len; output++) {
+        const uint32_t expected = brute_force_ghost_inputs(pressed, len, inputs, output);
+        const uint32_t actual = zmk_kscan_ghost_inputs(pressed, len, output);
+
+        zassert_equal(actual, expected, "output %d of %zu: got 0x%08x, expected 0x%08x", output,
+                      len, actual, expected);
+    }
+}
+
+ZTEST(zmk_kscan_ghost, test_rectangle) {
+    const uint32_t pressed[] = {0b0110, 0b0000, 0b0110, 0b0100};
+
+    zassert_equal(zmk_kscan_ghost_inputs(pressed, ARRAY_SIZE(pressed), 0), 0b0110);
+    zassert_equal(zmk_kscan_ghost_inputs(pressed, ARRAY_SIZE(pressed), 1), 0);
+    zassert_equal(zmk_kscan_ghost_inputs(pressed, ARRAY_SIZE(pressed), 2), 0b0110);
+    // Shares one input with the rectangle, but isn't part of it.
+    zassert_equal(zmk_kscan_ghost_inputs(pressed, ARRAY_SIZE(pressed), 3), 0);
+}
+
+/**
+ * Compares against the brute force search for every combination of pressed keys in a 3x4 matrix.
+ */
+ZTEST(zmk_kscan_ghost, test_all_small_matrices) {
+    const int outputs = 3;
+    const int inputs = 4;
+
+    for (uint32_t keys = 0; keys < BIT(outputs * inputs); keys++) {
+        uint32_t pressed[3];
+
+        for (int output = 0; output < outputs; output++) {
+            pressed[output] = (keys >> (output * inputs)) & BIT_MASK(inputs);
+        }
+
+        assert_matches_brute_force(pressed, outputs, inputs);
+    }
+}
+
+/**
+ * Compares against the brute force search for random sets of pressed keys in matrices with up to 32
+ * inputs.
+ */
+ZTEST(zmk_kscan_ghost, test_random_matrices) {
+    test_rand_seed(0x2a2a2a2a);
+
+    for (int trial = 0; trial < RANDOM_TRIALS; trial++) {
+        const size_t len = 1 + test_rand() % MAX_OUTPUTS;
+        const int inputs = 1 + test_rand() % MAX_INPUTS;
+        uint32_t pressed[MAX_OUTPUTS];
+
+        for (int output = 0; output < len; output++) {
+            // Sparse like real typing, but dense enough to form rectangles often.
+            pressed[output] = test_rand() & test_rand() & test_rand();
+
+            if (inputs < 32) {
+                pressed[output] &= BIT_MASK(inputs);
+            }
+        }
+
+        assert_matches_brute_force(pressed, len, inputs);
+    }
+}
+
+ZTEST_SUITE(zmk_kscan_ghost, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define DT_DRV_COMPAT zmk_kscan_shift_register
+
+// Long enough for the driver to poll at least once with the default poll-period-ms.
+#define SCAN_WAIT K_MSEC(25)
+
+/**
+ * Emulates a chain of 74HC165 shift registers, with QH of the register nearest the controller
+ * connected to MISO and each register's SER input connected to QH of the next one.
+ */
+struct hc165_emul_data {
+    /**
+     * Level of every input, with input A of the register nearest the controller in bit 0, input
+     * H of that register in bit 7 and input A of the next register in bit 8.
+     */
+    uint64_t levels;
+    int reads;
+    /** Transfers which the driver should never make. */
+    int errors;
+};
+
+struct hc165_emul_config {
+    struct gpio_dt_spec load_gpio;
+    size_t registers;
+};
+
+static int hc165_emul_io(const struct emul *target, const struct spi_config *config,
+                         const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs) {
+    struct hc165_emul_data *data = target->data;
+    const struct hc165_emul_config *cfg = target->cfg;
+
+    // The registers only shift while SH/LD is high, and the whole chain is read at once.
+    if (gpio_emul_output_get(cfg->load_gpio.port, cfg->load_gpio.pin) != 1 || tx_bufs ||
+        !rx_bufs || rx_bufs->count != 1 || rx_bufs->buffers[0].len != cfg->registers) {
+        data->errors++;
+        return -EINVAL;
+    }
+
+    uint8_t *buf = rx_bufs->buffers[0].buf;
+
+    for (int reg = 0; reg < cfg->registers; reg++) {
+        uint8_t byte = 0;
+
+        // Each register shifts out input H first, and SPI receives the most significant bit first.
+        for (int input = 7; input >= 0; input--) {
+            byte = (byte << 1) | ((data->levels >> (reg * 8 + input)) & 1);
+        }
+
+        buf[reg] = byte;
+    }
+
+    data->reads++;
+    return 0;
+}
+
+static const struct spi_emul_api hc165_emul_api = {
+    .io = hc165_emul_io,
+};
+
+static int hc165_emul_init(const struct emul *target, const struct device *parent) { return 0; }
+
+#define HC165_EMUL_INIT(n)                                                                         \
+    static struct hc165_emul_data hc165_emul_data_##n = {                                          \
+        /* Released keys pull active low inputs high. */                                           \
+        .levels = DT_INST_PROP(n, active_low) ? BIT64_MASK(DT_INST_PROP(n, ngpios)) : 0,           \
+    };                                                                                             \
+                                                                                                   \
+    static const struct hc165_emul_config hc165_emul_config_##n = {                                \
+        .load_gpio = GPIO_DT_SPEC_INST_GET(n, load_gpios),                                         \
+        .registers = DT_INST_PROP(n, ngpios) / 8,                                                  \
+    };                                                                                             \
+                                                                                                   \
+    EMUL_DT_INST_DEFINE(n, hc165_emul_init, &hc165_emul_data_##n, &hc165_emul_config_##n,          \
+                        &hc165_emul_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(HC165_EMUL_INIT)
+
+struct kscan_event {
+    const struct device *dev;
+    uint32_t row;
+    uint32_t column;
+    bool pressed;
+};
+
+K_MSGQ_DEFINE(kscan_events, sizeof(struct kscan_event), 16, 4);
+
+static const struct device *const active_high_dev = DEVICE_DT_GET(DT_NODELABEL(kscan_active_high));
+static const struct device *const active_low_dev = DEVICE_DT_GET(DT_NODELABEL(kscan_active_low));
+
+static const struct emul *const active_high_emul = EMUL_DT_GET(DT_NODELABEL(kscan_active_high));
+static const struct emul *const active_low_emul = EMUL_DT_GET(DT_NODELABEL(kscan_active_low));
+
+static void kscan_callback(const struct device *dev, uint32_t row, uint32_t column, bool pressed) {
+    const struct kscan_event event = {
+        .dev = dev,
+        .row = row,
+        .column = column,
+        .pressed = pressed,
+    };
+
+    k_msgq_put(&kscan_events, &event, K_NO_WAIT);
+}
+
+static void set_levels(const struct emul *emul, uint64_t levels) {
+    struct hc165_emul_data *data = emul->data;
+
+    data->levels = levels;
+    k_sleep(SCAN_WAIT);
+}
+
+static void expect_event(const struct device *dev, uint32_t column, bool pressed) {
+    struct kscan_event event;
+
+    zassert_ok(k_msgq_get(&kscan_events, &event, K_NO_WAIT), "no event for column %u", column);
+    zassert_equal_ptr(event.dev, dev);
+    zassert_equal(event.row, 0);
+    zassert_equal(event.column, column, "got column %u, expected %u", event.column, column);
+    zassert_equal(event.pressed, pressed, "column %u", column);
+}
+
+static void expect_no_events(void) {
+    zassert_equal(k_msgq_num_used_get(&kscan_events), 0, "unexpected key events");
+}
+
+static void *setup(void) {
+    zassert_true(device_is_ready(active_high_dev));
+    zassert_true(device_is_ready(active_low_dev));
+
+    zassert_ok(kscan_config(active_high_dev, kscan_callback));
+    zassert_ok(kscan_config(active_low_dev, kscan_callback));
+    zassert_ok(kscan_enable_callback(active_high_dev));
+    zassert_ok(kscan_enable_callback(active_low_dev));
+
+    k_sleep(SCAN_WAIT);
+    return NULL;
+}
+
+static void before(void *fixture) { k_msgq_purge(&kscan_events); }
+
+static void after(void *fixture) {
+    const struct hc165_emul_data *active_high = active_high_emul->data;
+    const struct hc165_emul_data *active_low = active_low_emul->data;
+
+    zassert_true(active_high->reads > 0);
+    zassert_true(active_low->reads > 0);
+    zassert_equal(active_high->errors, 0, "bad transfers to the active high chain");
+    zassert_equal(active_low->errors, 0, "bad transfers to the active low chain");
+}
+
+/**
+ * The first byte read is the nearest register and bit 0 of each byte is input A, so input A of
+ * register r is column r * 8, including past the first 32-bit word.
+ */
+ZTEST(zmk_kscan_shift_register, test_bit_order) {
+    static const uint32_t columns[] = {0, 1, 7, 8, 15, 16, 31, 32, 39};
+
+    for (int i = 0; i < ARRAY_SIZE(columns); i++) {
+        set_levels(active_high_emul, BIT64(columns[i]));
+        expect_event(active_high_dev, columns[i], true);
+        expect_no_events();
+
+        set_levels(active_high_emul, 0);
+        expect_event(active_high_dev, columns[i], false);
+        expect_no_events();
+    }
+}
+
+ZTEST(zmk_kscan_shift_register, test_several_keys) {
+    set_levels(active_high_emul, BIT64(3) | BIT64(12) | BIT64(35));
+    expect_event(active_high_dev, 3, true);
+    expect_event(active_high_dev, 12, true);
+    expect_event(active_high_dev, 35, true);
+    expect_no_events();
+
+    set_levels(active_high_emul, BIT64(12));
+    expect_event(active_high_dev, 3, false);
+    expect_event(active_high_dev, 35, false);
+    expect_no_events();
+
+    set_levels(active_high_emul, 0);
+    expect_event(active_high_dev, 12, false);
+    expect_no_events();
+}
+
+/**
+ * With active-low, the unused bytes of the last word are padding rather than inputs reading low,
+ * so they must never be reported.
+ */
+ZTEST(zmk_kscan_shift_register, test_active_low_padding) {
+    const uint64_t released = BIT64_MASK(24);
+
+    set_levels(active_low_emul, released);
+    expect_no_events();
+
+    set_levels(active_low_emul, released & ~BIT64(0));
+    expect_event(active_low_dev, 0, true);
+    expect_no_events();
+
+    set_levels(active_low_emul, released & ~BIT64(23));
+    expect_event(active_low_dev, 0, false);
+    expect_event(active_low_dev, 23, true);
+    expect_no_events();
+
+    set_levels(active_low_emul, released);
+    expect_event(active_low_dev, 23, false);
+    expect_no_events();
+}
+
+ZTEST_SUITE(zmk_kscan_shift_register, NULL, setup, before, after, NULL);
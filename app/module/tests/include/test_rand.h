@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * xorshift32, so random tests do the same thing on every run and failures can be reproduced from
+ * the printed trial number.
+ */
+
+static uint32_t test_rand_state = 0x2a2a2a2a;
+
+static inline void test_rand_seed(uint32_t seed) { test_rand_state = seed; }
+
+static inline uint32_t test_rand(void) {
+    test_rand_state ^= test_rand_state << 13;
+    test_rand_state ^= test_rand_state >> 17;
+    test_rand_state ^= test_rand_state << 5;
+    return test_rand_state;
+}
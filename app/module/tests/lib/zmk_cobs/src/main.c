@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/cobs.h>
+
+#define MAX_DATA_LEN 600
+
+static uint8_t data[MAX_DATA_LEN];
+static uint8_t encoded[ZMK_COBS_FRAME_MAX_LEN(MAX_DATA_LEN)];
+static uint8_t decoded[ZMK_COBS_FRAME_MAX_LEN(MAX_DATA_LEN)];
+
+/**
+ * Fills data with a pattern which has a zero every `zero_period` bytes, or none if zero_period is
+ * 0, and no other zeros.
+ */
+static void fill_data(size_t len, size_t zero_period) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (zero_period && i % zero_period == zero_period - 1) ? 0 : 1 + (i * 7) % 255;
+    }
+}
+
+static void assert_no_zeros(const uint8_t *buf, size_t len) {
+    zassert_is_null(memchr(buf, 0, len), "zero byte in encoded data");
+}
+
+static void assert_round_trip(size_t len) {
+    size_t encoded_len = zmk_cobs_encode(data, len, encoded);
+
+    zassert_true(encoded_len <= ZMK_COBS_ENCODED_MAX_LEN(len), "len %zu: encoded to %zu bytes",
+                 len, encoded_len);
+    assert_no_zeros(encoded, encoded_len);
+
+    zassert_equal(zmk_cobs_decode(encoded, encoded_len, decoded), len, "len %zu", len);
+    zassert_mem_equal(decoded, data, len, "len %zu", len);
+}
+
+static void assert_encodes_to(const uint8_t *src, size_t len, const uint8_t *expected,
+                              size_t expected_len) {
+    zassert_equal(zmk_cobs_encode(src, len, encoded), expected_len);
+    zassert_mem_equal(encoded, expected, expected_len);
+}
+
+ZTEST(zmk_cobs, test_encode) {
+    assert_encodes_to(NULL, 0, (uint8_t[]){0x01}, 1);
+    assert_encodes_to((uint8_t[]){0x00}, 1, (uint8_t[]){0x01, 0x01}, 2);
+    assert_encodes_to((uint8_t[]){0x00, 0x00}, 2, (uint8_t[]){0x01, 0x01, 0x01}, 3);
+    assert_encodes_to((uint8_t[]){0x11, 0x22, 0x00, 0x33}, 4,
+                      (uint8_t[]){0x03, 0x11, 0x22, 0x02, 0x33}, 5);
+    assert_encodes_to((uint8_t[]){0x11, 0x22, 0x33, 0x44}, 4,
+                      (uint8_t[]){0x05, 0x11, 0x22, 0x33, 0x44}, 5);
+    assert_encodes_to((uint8_t[]){0x11, 0x00, 0x00, 0x00}, 4,
+                      (uint8_t[]){0x02, 0x11, 0x01, 0x01, 0x01}, 5);
+}
+
+/**
+ * A run of 254 non-zero bytes fills a block, so each one needs another code byte. Runs of those
+ * lengths must encode to exactly the maximum length.
+ */
+ZTEST(zmk_cobs, test_run_boundary) {
+    static const size_t lens[] = {253, 254, 255, 507, 508, 509};
+
+    for (int i = 0; i < ARRAY_SIZE(lens); i++) {
+        fill_data(lens[i], 0);
+        assert_round_trip(lens[i]);
+        zassert_equal(zmk_cobs_encode(data, lens[i], encoded), ZMK_COBS_ENCODED_MAX_LEN(lens[i]),
+                      "len %zu", lens[i]);
+    }
+
+    // A zero just after a full block.
+    fill_data(255, 255);
+    assert_round_trip(255);
+}
+
+ZTEST(zmk_cobs, test_round_trip) {
+    static const size_t zero_periods[] = {0, 1, 2, 3, 100, 254, 255, 256};
+
+    for (int i = 0; i < ARRAY_SIZE(zero_periods); i++) {
+        for (size_t len = 0; len <= MAX_DATA_LEN; len++) {
+            fill_data(len, zero_periods[i]);
+            assert_round_trip(len);
+        }
+    }
+}
+
+ZTEST(zmk_cobs, test_frame_round_trip) {
+    for (size_t len = 0; len <= MAX_DATA_LEN; len++) {
+        fill_data(len, 5);
+
+        size_t frame_len = zmk_cobs_frame_encode(data, len, encoded);
+
+        zassert_true(frame_len <= ZMK_COBS_FRAME_MAX_LEN(len), "len %zu: frame of %zu bytes", len,
+                     frame_len);
+        zassert_equal(encoded[frame_len - 1], 0, "len %zu: frame not delimited", len);
+        assert_no_zeros(encoded, frame_len - 1);
+
+        zassert_equal(zmk_cobs_frame_decode(encoded, frame_len - 1), len, "len %zu", len);
+        zassert_mem_equal(encoded, data, len, "len %zu", len);
+    }
+}
+
+/**
+ * Every single bit error which doesn't turn a byte into a delimiter must be caught by either the
+ * COBS structure or the CRC.
+ */
+ZTEST(zmk_cobs, test_frame_corrupt) {
+    const size_t len = 40;
+
+    fill_data(len, 6);
+    size_t frame_len = zmk_cobs_frame_encode(data, len, encoded);
+
+    for (size_t i = 0; i < frame_len - 1; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            zmk_cobs_frame_encode(data, len, decoded);
+            decoded[i] ^= BIT(bit);
+            if (decoded[i] == 0) {
+                continue;
+            }
+
+            zassert_true(zmk_cobs_frame_decode(decoded, frame_len - 1) < 0,
+                         "byte %zu bit %d: corrupt frame accepted", i, bit);
+        }
+    }
+}
+
+ZTEST(zmk_cobs, test_frame_truncated) {
+    const size_t len = 40;
+
+    fill_data(len, 6);
+    size_t frame_len = zmk_cobs_frame_encode(data, len, encoded);
+
+    for (size_t truncated_len = 0; truncated_len < frame_len - 1; truncated_len++) {
+        zmk_cobs_frame_encode(data, len, decoded);
+        zassert_true(zmk_cobs_frame_decode(decoded, truncated_len) < 0,
+                     "frame truncated to %zu bytes accepted", truncated_len);
+    }
+}
+
+ZTEST(zmk_cobs, test_invalid) {
+    // A code byte can never be zero.
+    zassert_equal(zmk_cobs_decode((uint8_t[]){0x02, 0x11, 0x00}, 3, decoded), -EINVAL);
+    // A code byte can't point past the end.
+    zassert_equal(zmk_cobs_decode((uint8_t[]){0x05, 0x11, 0x22}, 3, decoded), -EINVAL);
+    // Valid COBS, but too short to hold a CRC.
+    zassert_equal(zmk_cobs_frame_decode((uint8_t[]){0x02, 0x11}, 2), -EBADMSG);
+}
+
+ZTEST_SUITE(zmk_cobs, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+#include "test_rand.h"
+
+#define SWITCH_COUNT 32
+#define TRIALS 2000
+#define UPDATES_PER_TRIAL 500
+#define MAX_TEST_UPDATES 12
+
+static void init_configs(struct zmk_debounce_config *config,
+                         struct zmk_debounce_vertical_config *vertical_config, uint32_t press,
+                         uint32_t release, bool eager_press) {
+    *config = (struct zmk_debounce_config){
+        .debounce_press_ms = press,
+        .debounce_release_ms = release,
+        .eager_press = eager_press,
+    };
+
+    zassert_ok(zmk_debounce_vertical_config_init(vertical_config, press, release, eager_press));
+}
+
+static void assert_same_state(const struct zmk_debounce_state *states,
+                              const struct zmk_debounce_vertical_state *vertical,
+                              const struct zmk_debounce_vertical_config *vertical_config,
+                              int trial, int update) {
+    const uint32_t active = zmk_debounce_vertical_get_active(vertical, vertical_config);
+
+    for (int i = 0; i < SWITCH_COUNT; i++) {
+        const struct zmk_debounce_state *state = &states[i];
+
+        zassert_equal(zmk_debounce_is_pressed(state), (vertical->pressed & BIT(i)) != 0,
+                      "pressed differs: trial %d update %d switch %d", trial, update, i);
+        zassert_equal(zmk_debounce_get_changed(state), (vertical->changed & BIT(i)) != 0,
+                      "changed differs: trial %d update %d switch %d", trial, update, i);
+        zassert_equal(zmk_debounce_is_active(state), (active & BIT(i)) != 0,
+                      "active differs: trial %d update %d switch %d", trial, update, i);
+    }
+}
+
+ZTEST(zmk_debounce, test_vertical_config_init) {
+    struct zmk_debounce_vertical_config config;
+
+    zassert_ok(zmk_debounce_vertical_config_init(&config, 5, 0, false));
+    zassert_equal(config.counter_bits, 3);
+
+    zassert_ok(zmk_debounce_vertical_config_init(&config, 0, 0, false));
+    zassert_equal(config.counter_bits, 0);
+
+    zassert_ok(zmk_debounce_vertical_config_init(&config, 0, DEBOUNCE_VERTICAL_COUNTER_MAX, true));
+    zassert_equal(config.counter_bits, DEBOUNCE_VERTICAL_COUNTER_BITS);
+
+    zassert_equal(
+        zmk_debounce_vertical_config_init(&config, DEBOUNCE_VERTICAL_COUNTER_MAX + 1, 0, false),
+        -EINVAL);
+}
+
+/**
+ * Debounces random inputs with both debouncers, one millisecond per update, and checks that every
+ * switch ends up in the same state after every update.
+ */
+ZTEST(zmk_debounce, test_vertical_matches_scalar) {
+    test_rand_seed(0x2a2a2a2a);
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        struct zmk_debounce_config config;
+        struct zmk_debounce_vertical_config vertical_config;
+        struct zmk_debounce_state states[SWITCH_COUNT] = {0};
+        struct zmk_debounce_vertical_state vertical = {0};
+
+        init_configs(&config, &vertical_config, test_rand() % MAX_TEST_UPDATES,
+                     test_rand() % MAX_TEST_UPDATES, trial & 1);
+
+        for (int update = 0; update < UPDATES_PER_TRIAL; update++) {
+            uint32_t active;
+
+            // Mix noise with long runs of every switch held or released, so counters reach
+            // their thresholds as well as bouncing around below them.
+            if (update % 50 < 20) {
+                active = update % 100 < 50 ? UINT32_MAX : 0;
+            } else {
+                active = test_rand() & test_rand();
+            }
+
+            zmk_debounce_vertical_update(&vertical, active, &vertical_config);
+
+            for (int i = 0; i < SWITCH_COUNT; i++) {
+                zmk_debounce_update(&states[i], active & BIT(i), 1, &config);
+            }
+
+            assert_same_state(states, &vertical, &vertical_config, trial, update);
+        }
+    }
+}
+
+#define CHATTER_KEYSTROKES 1000
+#define CHATTER_DEBOUNCE_MS 5
+// Bounces must be shorter than the release debounce time, or they are real key presses.
+#define CHATTER_MAX_BOUNCE (CHATTER_DEBOUNCE_MS - 1)
+#define CHATTER_IDLE 30
+
+/**
+ * Returns whether a switch reads active at time t of a keystroke which bounces for the first and
+ * last `bounce` updates of `hold`, then stays released.
+ */
+static bool chatter_active(int t, int bounce, int hold) {
+    if (t == 0) {
+        return true;
+    }
+    if (t < bounce || (t >= hold - bounce && t < hold)) {
+        return test_rand() & 1;
+    }
+    return t < hold;
+}
+
+/**
+ * Eager press must report a bouncing keystroke as exactly one press, on its first active read, and
+ * exactly one release.
+ */
+ZTEST(zmk_debounce, test_eager_press_chatter) {
+    struct zmk_debounce_config config;
+    struct zmk_debounce_vertical_config vertical_config;
+    struct zmk_debounce_state states[SWITCH_COUNT] = {0};
+    struct zmk_debounce_vertical_state vertical = {0};
+
+    init_configs(&config, &vertical_config, CHATTER_DEBOUNCE_MS, CHATTER_DEBOUNCE_MS, true);
+    test_rand_seed(0x5eed5eed);
+
+    for (int keystroke = 0; keystroke < CHATTER_KEYSTROKES; keystroke++) {
+        const int bounce = test_rand() % (CHATTER_MAX_BOUNCE + 1);
+        const int hold = 2 * bounce + CHATTER_DEBOUNCE_MS + test_rand() % 100;
+        int presses[SWITCH_COUNT] = {0};
+        int releases[SWITCH_COUNT] = {0};
+        int vertical_presses[SWITCH_COUNT] = {0};
+        int vertical_releases[SWITCH_COUNT] = {0};
+
+        for (int t = 0; t < hold + CHATTER_IDLE; t++) {
+            uint32_t active = 0;
+
+            for (int i = 0; i < SWITCH_COUNT; i++) {
+                struct zmk_debounce_state *state = &states[i];
+                const bool switch_active = chatter_active(t, bounce, hold);
+
+                zmk_debounce_update(state, switch_active, 1, &config);
+                if (zmk_debounce_get_changed(state)) {
+                    zassert_true(!zmk_debounce_is_pressed(state) || t == 0,
+                                 "late press: keystroke %d switch %d t %d", keystroke, i, t);
+                    if (zmk_debounce_is_pressed(state)) {
+                        presses[i]++;
+                    } else {
+                        releases[i]++;
+                    }
+                }
+
+                active |= switch_active ? BIT(i) : 0;
+            }
+
+            zmk_debounce_vertical_update(&vertical, active, &vertical_config);
+
+            for (int i = 0; i < SWITCH_COUNT; i++) {
+                if (vertical.changed & BIT(i)) {
+                    zassert_true(!(vertical.pressed & BIT(i)) || t == 0,
+                                 "late vertical press: keystroke %d switch %d t %d", keystroke, i,
+                                 t);
+                    if (vertical.pressed & BIT(i)) {
+                        vertical_presses[i]++;
+                    } else {
+                        vertical_releases[i]++;
+                    }
+                }
+            }
+        }
+
+        for (int i = 0; i < SWITCH_COUNT; i++) {
+            zassert_equal(presses[i], 1, "keystroke %d switch %d", keystroke, i);
+            zassert_equal(releases[i], 1, "keystroke %d switch %d", keystroke, i);
+            zassert_equal(vertical_presses[i], 1, "keystroke %d switch %d", keystroke, i);
+            zassert_equal(vertical_releases[i], 1, "keystroke %d switch %d", keystroke, i);
+        }
+    }
+}
+
+ZTEST_SUITE(zmk_debounce, NULL, NULL, NULL, NULL, NULL);
@@ -6,8 +6,12 @@
 
 #include <zephyr/init.h>
 #include <zephyr/settings/settings.h>
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include <zmk/ble.h>
 #include <zmk/endpoints.h>
@@ -32,6 +36,52 @@ static enum zmk_transport preferred_transport =
 
 static void update_current_endpoint(void);
 
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+
+#define SENT_REPORT_TYPE_COUNT COND_CODE_1(IS_ENABLED(CONFIG_ZMK_MOUSE), (3), (2))
+
+BUILD_ASSERT(ZMK_HID_REPORT_ID_KEYBOARD == 1 && ZMK_HID_REPORT_ID_CONSUMER == 2,
+             "Sent reports are indexed by report ID");
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+BUILD_ASSERT(ZMK_HID_REPORT_ID_MOUSE == 3, "Sent reports are indexed by report ID");
+#endif
+
+struct sent_report {
+    bool valid;
+    union {
+        struct zmk_hid_keyboard_report_body keyboard;
+        struct zmk_hid_consumer_report_body consumer;
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+        struct zmk_hid_mouse_report_body mouse;
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+    } body;
+};
+
+// The last report of each type successfully sent to each endpoint instance.
+static struct sent_report sent_reports[ZMK_ENDPOINT_COUNT][SENT_REPORT_TYPE_COUNT];
+
+static struct zmk_endpoints_report_stats report_stats;
+
+struct zmk_endpoints_report_stats zmk_endpoints_get_report_stats(void) { return report_stats; }
+
+static void invalidate_sent_reports(void) { memset(sent_reports, 0, sizeof(sent_reports)); }
+
+void zmk_endpoints_invalidate_sent_reports(struct zmk_endpoint_instance endpoint) {
+    struct sent_report *sent = sent_reports[zmk_endpoint_instance_to_index(endpoint)];
+
+    for (int i = 0; i < SENT_REPORT_TYPE_COUNT; i++) {
+        sent[i].valid = false;
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
+// The USB protocol the sent reports were sent with. A host which switches protocol may have
+// reset its state, so the last reports must be sent again.
+static uint8_t sent_reports_usb_protocol = HID_PROTOCOL_REPORT;
+#endif
+
+#endif // IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+
 #if IS_ENABLED(CONFIG_SETTINGS)
 static void endpoints_save_preferred_work(struct k_work *work) {
     settings_save_one("endpoints/preferred", &preferred_transport, sizeof(preferred_transport));
@@ -188,15 +238,57 @@ static int send_consumer_report(void) {
     return -ENOTSUP;
 }
 
+static int send_report_if_changed(uint8_t report_id, const void *body, size_t len,
+                                  bool may_skip, int (*send)(void)) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
+    if (current_instance.transport == ZMK_TRANSPORT_USB &&
+        zmk_usb_hid_get_protocol() != sent_reports_usb_protocol) {
+        sent_reports_usb_protocol = zmk_usb_hid_get_protocol();
+        invalidate_sent_reports();
+    }
+#endif
+
+    struct sent_report *sent =
+        &sent_reports[zmk_endpoint_instance_to_index(current_instance)][report_id - 1];
+
+    if (may_skip && sent->valid && memcmp(&sent->body, body, len) == 0) {
+        LOG_DBG("Skipping report %d since it matches the last one sent", report_id);
+        report_stats.suppressed++;
+        return 0;
+    }
+
+    int err = send();
+    if (err) {
+        // We can't be sure what the host received, so always send the next report.
+        sent->valid = false;
+        return err;
+    }
+
+    sent->valid = true;
+    memcpy(&sent->body, body, len);
+    report_stats.sent++;
+    return 0;
+#else
+    return send();
+#endif // IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+}
+
 int zmk_endpoints_send_report(uint16_t usage_page) {
 
     LOG_DBG("usage page 0x%02X", usage_page);
     switch (usage_page) {
-    case HID_USAGE_KEY:
-        return send_keyboard_report();
+    case HID_USAGE_KEY: {
+        struct zmk_hid_keyboard_report *report = zmk_hid_get_keyboard_report();
+        return send_report_if_changed(ZMK_HID_REPORT_ID_KEYBOARD, &report->body,
+                                      sizeof(report->body), true, send_keyboard_report);
+    }
 
-    case HID_USAGE_CONSUMER:
-        return send_consumer_report();
+    case HID_USAGE_CONSUMER: {
+        struct zmk_hid_consumer_report *report = zmk_hid_get_consumer_report();
+        return send_report_if_changed(ZMK_HID_REPORT_ID_CONSUMER, &report->body,
+                                      sizeof(report->body), true, send_consumer_report);
+    }
     }
 
     LOG_ERR("Unsupported usage page %d", usage_page);
@@ -204,7 +296,7 @@ int zmk_endpoints_send_report(uint16_t usage_page) {
 }
 
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
-int zmk_endpoints_send_mouse_report() {
+static int send_mouse_report(void) {
     switch (current_instance.transport) {
     case ZMK_TRANSPORT_USB: {
 #if IS_ENABLED(CONFIG_ZMK_USB)
@@ -237,8 +329,41 @@ int zmk_endpoints_send_mouse_report() {
     LOG_ERR("Unhandled endpoint transport %d", current_instance.transport);
     return -ENOTSUP;
 }
+
+int zmk_endpoints_send_mouse_report() {
+    struct zmk_hid_mouse_report *report = zmk_hid_get_mouse_report();
+
+    // Movement is relative, so a report with movement is never a duplicate.
+    bool has_movement = report->body.d_x || report->body.d_y || report->body.d_wheel;
+
+    return send_report_if_changed(ZMK_HID_REPORT_ID_MOUSE, &report->body, sizeof(report->body),
+                                  !has_movement, send_mouse_report);
+}
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
 
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS) && IS_ENABLED(CONFIG_SHELL)
+
+static int endpoints_cmd_stats(const struct shell *sh, size_t argc, char **argv) {
+    struct zmk_endpoints_report_stats stats = zmk_endpoints_get_report_stats();
+
+    shell_print(sh, "%u reports sent, %u duplicate reports skipped", stats.sent, stats.suppressed);
+    return 0;
+}
+
+static int endpoints_cmd_reset(const struct shell *sh, size_t argc, char **argv) {
+    report_stats = (struct zmk_endpoints_report_stats){0};
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    endpoints_cmds, SHELL_CMD(stats, NULL, "Print report statistics", endpoints_cmd_stats),
+    SHELL_CMD(reset, NULL, "Reset report statistics", endpoints_cmd_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(endpoints, &endpoints_cmds, "Endpoint commands", NULL);
+
+#endif // IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS) && IS_ENABLED(CONFIG_SHELL)
+
 #if IS_ENABLED(CONFIG_SETTINGS)
 
 static int endpoints_handle_set(const char *name, size_t len, settings_read_cb read_cb,
@@ -351,6 +476,11 @@ static void update_current_endpoint(void) {
 
         current_instance = new_instance;
 
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+        // The new endpoint may not have seen the reports last sent to it.
+        invalidate_sent_reports();
+#endif
+
         char endpoint_str[ZMK_ENDPOINT_STR_LEN];
         zmk_endpoint_instance_to_str(current_instance, endpoint_str, sizeof(endpoint_str));
         LOG_INF("Endpoint changed: %s", endpoint_str);
@@ -360,6 +490,11 @@ static void update_current_endpoint(void) {
 }
 
 static int endpoint_listener(const zmk_event_t *eh) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+    // The connection to a host changed, so it may not have the last reports we sent.
+    invalidate_sent_reports();
+#endif
+
     update_current_endpoint();
     return 0;
 }
@@ -21,10 +21,12 @@ static struct zmk_hid_consumer_report consumer_report = {.report_id = ZMK_HID_RE
 #if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
 
 static zmk_hid_boot_report_t boot_report = {.modifiers = 0, ._reserved = 0, .keys = {0}};
-static uint8_t keys_held = 0;
 
 #endif /* IS_ENABLED(CONFIG_ZMK_USB_BOOT) */
 
+// Number of non-modifier keyboard usages currently pressed.
+static uint8_t keys_held = 0;
+
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
 
 static struct zmk_hid_mouse_report mouse_report = {.report_id = ZMK_HID_REPORT_ID_MOUSE,
@@ -39,6 +41,21 @@ static zmk_mod_flags_t explicit_modifiers = 0;
 static zmk_mod_flags_t implicit_modifiers = 0;
 static zmk_mod_flags_t masked_modifiers = 0;
 
+// Every held usage keeps the implicit modifiers it was pressed with, ordered from
+// oldest to most recent press. The active implicit modifiers are those of the most
+// recently pressed usage still held, so releasing a key restores the modifiers of
+// the key pressed before it instead of clearing them.
+#define IMPLICIT_MODIFIERS_MAX_HELD 10
+
+struct implicit_modifiers_entry {
+    uint32_t usage;
+    zmk_mod_flags_t modifiers;
+    uint8_t count;
+};
+
+static struct implicit_modifiers_entry implicit_modifiers_held[IMPLICIT_MODIFIERS_MAX_HELD];
+static int implicit_modifiers_held_len = 0;
+
 #define SET_MODIFIERS(mods)                                                                        \
     {                                                                                              \
         keyboard_report.body.modifiers = (mods & ~masked_modifiers) | implicit_modifiers;          \
@@ -116,6 +133,17 @@ static zmk_hid_boot_report_t *boot_report_rollover(uint8_t modifiers) {
 
 #define TOGGLE_KEYBOARD(code, val) WRITE_BIT(keyboard_report.body.keys[code / 8], code % 8, val)
 
+BUILD_ASSERT(ZMK_HID_KEYBOARD_NKRO_MAX_USAGE <= UINT8_MAX,
+             "NKRO usages must fit in the pressed usage list");
+
+// Usages set in the NKRO bitmap, kept alongside it as a dense list so that the
+// boot report can be built without scanning the whole bitmap. The first
+// keys_held entries are valid.
+static uint8_t pressed_usages[ZMK_HID_KEYBOARD_NKRO_MAX_USAGE + 1];
+
+// Index of each usage in pressed_usages plus one, or zero if it is not pressed.
+static uint8_t pressed_usage_slots[ZMK_HID_KEYBOARD_NKRO_MAX_USAGE + 1];
+
 #if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
 zmk_hid_boot_report_t *zmk_hid_get_boot_report(void) {
     if (keys_held > HID_BOOT_KEY_LEN) {
@@ -124,22 +152,7 @@ zmk_hid_boot_report_t *zmk_hid_get_boot_report(void) {
 
     boot_report.modifiers = keyboard_report.body.modifiers;
     memset(&boot_report.keys, 0, HID_BOOT_KEY_LEN);
-    int ix = 0;
-    uint8_t base_code = 0;
-    for (int i = 0; i < sizeof(keyboard_report.body.keys); ++i) {
-        if (ix == keys_held) {
-            break;
-        }
-        if (!keyboard_report.body.keys[i]) {
-            continue;
-        }
-        base_code = i * 8;
-        for (int j = 0; j < 8; ++j) {
-            if (keyboard_report.body.keys[i] & BIT(j)) {
-                boot_report.keys[ix++] = base_code + j;
-            }
-        }
-    }
+    memcpy(&boot_report.keys, pressed_usages, keys_held);
     return &boot_report;
 }
 #endif
@@ -148,10 +161,12 @@ static inline int select_keyboard_usage(zmk_key_t usage) {
     if (usage > ZMK_HID_KEYBOARD_NKRO_MAX_USAGE) {
         return -EINVAL;
     }
+    if (pressed_usage_slots[usage]) {
+        return 0;
+    }
     TOGGLE_KEYBOARD(usage, 1);
-#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
-    ++keys_held;
-#endif
+    pressed_usages[keys_held++] = usage;
+    pressed_usage_slots[usage] = keys_held;
     return 0;
 }
 
@@ -159,10 +174,16 @@ static inline int deselect_keyboard_usage(zmk_key_t usage) {
     if (usage > ZMK_HID_KEYBOARD_NKRO_MAX_USAGE) {
         return -EINVAL;
     }
+    const uint8_t slot = pressed_usage_slots[usage];
+    if (!slot) {
+        return 0;
+    }
     TOGGLE_KEYBOARD(usage, 0);
-#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
-    --keys_held;
-#endif
+    // Move the last pressed usage into the freed slot to keep the list dense.
+    const uint8_t last = pressed_usages[--keys_held];
+    pressed_usages[slot - 1] = last;
+    pressed_usage_slots[last] = slot;
+    pressed_usage_slots[usage] = 0;
     return 0;
 }
 
@@ -175,17 +196,6 @@ static inline bool check_keyboard_usage(zmk_key_t usage) {
 
 #elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
 
-#define TOGGLE_KEYBOARD(match, val)                                                                \
-    for (int idx = 0; idx < CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE; idx++) {                          \
-        if (keyboard_report.body.keys[idx] != match) {                                             \
-            continue;                                                                              \
-        }                                                                                          \
-        keyboard_report.body.keys[idx] = val;                                                      \
-        if (val) {                                                                                 \
-            break;                                                                                 \
-        }                                                                                          \
-    }
-
 #if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
 zmk_hid_boot_report_t *zmk_hid_get_boot_report(void) {
     if (keys_held > HID_BOOT_KEY_LEN) {
@@ -220,18 +230,32 @@ zmk_hid_boot_report_t *zmk_hid_get_boot_report(void) {
 #endif /* IS_ENABLED(CONFIG_ZMK_USB_BOOT) */
 
 static inline int select_keyboard_usage(zmk_key_t usage) {
-    TOGGLE_KEYBOARD(0U, usage);
-#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
-    ++keys_held;
-#endif
+    int free_idx = -1;
+    for (int idx = 0; idx < CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE; idx++) {
+        if (keyboard_report.body.keys[idx] == usage) {
+            // Already in the report.
+            return 0;
+        }
+        if (free_idx < 0 && keyboard_report.body.keys[idx] == 0U) {
+            free_idx = idx;
+        }
+    }
+
+    // Only count usages that actually made it into the report; a full report drops the press.
+    if (free_idx >= 0) {
+        keyboard_report.body.keys[free_idx] = usage;
+        ++keys_held;
+    }
     return 0;
 }
 
 static inline int deselect_keyboard_usage(zmk_key_t usage) {
-    TOGGLE_KEYBOARD(usage, 0U);
-#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
-    --keys_held;
-#endif
+    for (int idx = 0; idx < CONFIG_ZMK_HID_KEYBOARD_REPORT_SIZE; idx++) {
+        if (keyboard_report.body.keys[idx] == usage) {
+            keyboard_report.body.keys[idx] = 0U;
+            --keys_held;
+        }
+    }
     return 0;
 }
 
@@ -262,15 +286,58 @@ static inline int check_keyboard_usage(zmk_key_t usage) {
         }                                                                                          \
     }
 
-int zmk_hid_implicit_modifiers_press(zmk_mod_flags_t new_implicit_modifiers) {
-    implicit_modifiers = new_implicit_modifiers;
+static int implicit_modifiers_find(uint32_t usage) {
+    for (int i = 0; i < implicit_modifiers_held_len; i++) {
+        if (implicit_modifiers_held[i].usage == usage) {
+            return i;
+        }
+    }
+    return -ENOENT;
+}
+
+static void implicit_modifiers_remove(int idx) {
+    memmove(&implicit_modifiers_held[idx], &implicit_modifiers_held[idx + 1],
+            (implicit_modifiers_held_len - idx - 1) * sizeof(implicit_modifiers_held[0]));
+    implicit_modifiers_held_len--;
+}
+
+static void implicit_modifiers_recompute(void) {
+    implicit_modifiers = implicit_modifiers_held_len > 0
+                             ? implicit_modifiers_held[implicit_modifiers_held_len - 1].modifiers
+                             : 0;
+}
+
+int zmk_hid_implicit_modifiers_press(uint32_t usage, zmk_mod_flags_t new_implicit_modifiers) {
+    uint8_t count = 0;
+    int idx = implicit_modifiers_find(usage);
+    if (idx >= 0) {
+        count = implicit_modifiers_held[idx].count;
+        implicit_modifiers_remove(idx);
+    } else if (implicit_modifiers_held_len == IMPLICIT_MODIFIERS_MAX_HELD) {
+        LOG_WRN("Too many keys held, forgetting implicit modifiers of usage 0x%08X",
+                implicit_modifiers_held[0].usage);
+        implicit_modifiers_remove(0);
+    }
+
+    implicit_modifiers_held[implicit_modifiers_held_len++] = (struct implicit_modifiers_entry){
+        .usage = usage,
+        .modifiers = new_implicit_modifiers,
+        .count = count + 1,
+    };
+
+    implicit_modifiers_recompute();
     zmk_mod_flags_t current = GET_MODIFIERS;
     SET_MODIFIERS(explicit_modifiers);
     return current == GET_MODIFIERS ? 0 : 1;
 }
 
-int zmk_hid_implicit_modifiers_release(void) {
-    implicit_modifiers = 0;
+int zmk_hid_implicit_modifiers_release(uint32_t usage) {
+    int idx = implicit_modifiers_find(usage);
+    if (idx >= 0 && --implicit_modifiers_held[idx].count == 0) {
+        implicit_modifiers_remove(idx);
+    }
+
+    implicit_modifiers_recompute();
     zmk_mod_flags_t current = GET_MODIFIERS;
     SET_MODIFIERS(explicit_modifiers);
     return current == GET_MODIFIERS ? 0 : 1;
@@ -315,6 +382,10 @@ bool zmk_hid_keyboard_is_pressed(zmk_key_t code) {
 
 void zmk_hid_keyboard_clear(void) {
     memset(&keyboard_report.body, 0, sizeof(keyboard_report.body));
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_NKRO)
+    memset(pressed_usage_slots, 0, sizeof(pressed_usage_slots));
+#endif
+    keys_held = 0;
 }
 
 int zmk_hid_consumer_press(zmk_key_t code) {
@@ -42,7 +42,8 @@ static int hid_listener_keycode_pressed(const struct zmk_keycode_state_changed *
         return err;
     }
     explicit_mods_changed = zmk_hid_register_mods(ev->explicit_modifiers);
-    implicit_mods_changed = zmk_hid_implicit_modifiers_press(ev->implicit_modifiers);
+    implicit_mods_changed = zmk_hid_implicit_modifiers_press(
+        ZMK_HID_USAGE(ev->usage_page, ev->keycode), ev->implicit_modifiers);
     if (ev->usage_page != HID_USAGE_KEY &&
         (explicit_mods_changed > 0 || implicit_mods_changed > 0)) {
         err = zmk_endpoints_send_report(HID_USAGE_KEY);
@@ -78,12 +79,11 @@ static int hid_listener_keycode_released(const struct zmk_keycode_state_changed
 #endif // IS_ENABLED(CONFIG_ZMK_HID_SEPARATE_MOD_RELEASE_REPORT)
 
     explicit_mods_changed = zmk_hid_unregister_mods(ev->explicit_modifiers);
-    // There is a minor issue with this code.
-    // If LC(A) is pressed, then LS(B), then LC(A) is released, the shift for B will be released
-    // prematurely. This causes if LS(B) to repeat like Bbbbbbbb when pressed for a long time.
-    // Solving this would require keeping track of which key's implicit modifiers are currently
-    // active and only releasing modifiers at that time.
-    implicit_mods_changed = zmk_hid_implicit_modifiers_release();
+    // Implicit modifiers fall back to those of the most recent key still held, so releasing
+    // LC(A) while LS(B) is held keeps the shift for B, and tapping LC(B) while LS(A) is held
+    // restores the shift for A.
+    implicit_mods_changed =
+        zmk_hid_implicit_modifiers_release(ZMK_HID_USAGE(ev->usage_page, ev->keycode));
 
     if (ev->usage_page != HID_USAGE_KEY &&
         (explicit_mods_changed > 0 || implicit_mods_changed > 0)) {
@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include <zephyr/types.h>
 #include <zephyr/init.h>
 
@@ -13,6 +16,7 @@
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/hci.h>
 #include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/byteorder.h>
 
 #include <zephyr/logging/log.h>
@@ -20,20 +24,89 @@
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/stdlib.h>
+#include <zmk/activity.h>
 #include <zmk/ble.h>
 #include <zmk/behavior.h>
 #include <zmk/sensors.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
-#include <zmk/event_manager.h>
-#include <zmk/events/position_state_changed.h>
-#include <zmk/events/sensor_event.h>
-#include <zmk/events/battery_state_changed.h>
+#include <zmk/split/central.h>
+#include <zmk/split/transport/central.h>
 #include <zmk/hid_indicators_types.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
 
 static int start_scanning(void);
 
-#define POSITION_STATE_DATA_LEN 16
+#define POSITION_STATE_DATA_LEN ZMK_SPLIT_POS_STATE_LEN
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+// Number of notifications after which the peripheral clock offset is re-estimated, allowing it to
+// follow drift between the peripheral and central clocks.
+#define PERIPHERAL_CLOCK_SYNC_WINDOW 32
+
+// Offset between the central and peripheral uptime. Notification delays only ever add to the
+// observed offset, so the smallest one seen is the best estimate.
+struct peripheral_clock {
+    int64_t offset;
+    int64_t window_offset;
+    uint8_t window_samples;
+    bool synced;
+};
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+BUILD_ASSERT(CONFIG_ZMK_SPLIT_BLE_CENTRAL_SPLIT_RUN_QUEUE_SIZE < 128,
+             "Unacknowledged behavior invocations must fit half the sequence number range");
+
+#define RUN_BEHAVIOR_BATCH_WRITE_MAX_LEN (CONFIG_BT_L2CAP_TX_MTU - 3)
+#define RUN_BEHAVIOR_BATCH_ACK_VALID BIT(8)
+
+struct run_behavior_batch {
+    uint16_t handle;
+    struct bt_gatt_subscribe_params subscribe_params;
+    // Sequence number of items[0]. Items before `sent` were written and await acknowledgement.
+    uint8_t seq;
+    uint8_t count;
+    uint8_t sent;
+    int64_t sent_at;
+    // Latest acknowledgement from the peripheral, with RUN_BEHAVIOR_BATCH_ACK_VALID set until it's
+    // applied by the split run work.
+    atomic_t ack;
+    struct zmk_split_run_behavior_batch_item
+        items[CONFIG_ZMK_SPLIT_BLE_CENTRAL_SPLIT_RUN_QUEUE_SIZE];
+};
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+#define GATT_DB_HASH_LEN 16
+
+// Handles discovered on a peripheral, persisted so reconnecting can skip discovery as long as the
+// peripheral's GATT database hash is unchanged. Handles of features not enabled are left as zero.
+struct peripheral_handle_cache {
+    uint8_t db_hash[GATT_DB_HASH_LEN];
+    uint16_t run_behavior;
+    uint16_t run_behavior_batch;
+    uint16_t run_behavior_batch_ccc;
+    uint16_t position_state;
+    uint16_t position_state_ccc;
+    uint16_t position_events;
+    uint16_t position_events_ccc;
+    uint16_t sensor_state;
+    uint16_t sensor_state_ccc;
+    uint16_t update_hid_indicators;
+    uint16_t batt_lvl;
+    uint16_t batt_lvl_ccc;
+} __packed;
+
+static struct peripheral_handle_cache handle_caches[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
 
 enum peripheral_slot_state {
     PERIPHERAL_SLOT_STATE_OPEN,
@@ -49,6 +122,17 @@ struct peripheral_slot {
     struct bt_gatt_subscribe_params sensor_subscribe_params;
     struct bt_gatt_discover_params sub_discover_params;
     uint16_t run_behavior_handle;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    struct run_behavior_batch run_behavior_batch;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    uint16_t position_state_handle;
+    struct bt_gatt_subscribe_params position_events_subscribe_params;
+    struct bt_gatt_read_params position_state_read_params;
+    uint8_t position_events_seq;
+    bool position_events_seq_valid;
+    struct peripheral_clock clock;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
     struct bt_gatt_subscribe_params batt_lvl_subscribe_params;
     struct bt_gatt_read_params batt_lvl_read_params;
@@ -56,6 +140,12 @@ struct peripheral_slot {
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     uint16_t update_hid_indicators;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    struct bt_gatt_read_params db_hash_read_params;
+    uint8_t db_hash[GATT_DB_HASH_LEN];
+    bool db_hash_valid;
+    bool handles_from_cache;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
     uint8_t position_state[POSITION_STATE_DATA_LEN];
     uint8_t changed_positions[POSITION_STATE_DATA_LEN];
 };
@@ -66,18 +156,7 @@ static bool is_scanning = false;
 
 static const struct bt_uuid_128 split_service_uuid = BT_UUID_INIT_128(ZMK_SPLIT_BT_SERVICE_UUID);
 
-K_MSGQ_DEFINE(peripheral_event_msgq, sizeof(struct zmk_position_state_changed),
-              CONFIG_ZMK_SPLIT_BLE_CENTRAL_POSITION_QUEUE_SIZE, 4);
-
-void peripheral_event_work_callback(struct k_work *work) {
-    struct zmk_position_state_changed ev;
-    while (k_msgq_get(&peripheral_event_msgq, &ev, K_NO_WAIT) == 0) {
-        LOG_DBG("Trigger key position state change for %d", ev.position);
-        raise_zmk_position_state_changed(ev);
-    }
-}
-
-K_WORK_DEFINE(peripheral_event_work, peripheral_event_work_callback);
+static const struct zmk_split_transport_central bt_central_transport;
 
 int peripheral_slot_index_for_conn(struct bt_conn *conn) {
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
@@ -117,21 +196,8 @@ int release_peripheral_slot(int index) {
     }
     slot->state = PERIPHERAL_SLOT_STATE_OPEN;
 
-    // Raise events releasing any active positions from this peripheral
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->position_state[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                struct zmk_position_state_changed ev = {.source = index,
-                                                        .position = position,
-                                                        .state = false,
-                                                        .timestamp = k_uptime_get()};
-
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
-        }
-    }
+    // Releases any active positions from this peripheral
+    zmk_split_transport_central_peripheral_status_changed(&bt_central_transport, index, false);
 
     for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
         slot->position_state[i] = 0U;
@@ -141,9 +207,28 @@ int release_peripheral_slot(int index) {
     // Clean up previously discovered handles;
     slot->subscribe_params.value_handle = 0;
     slot->run_behavior_handle = 0;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    // The peripheral also restarts its sequence numbers on every connection.
+    slot->run_behavior_batch.handle = 0;
+    slot->run_behavior_batch.subscribe_params.value_handle = 0;
+    slot->run_behavior_batch.seq = 0;
+    slot->run_behavior_batch.count = 0;
+    slot->run_behavior_batch.sent = 0;
+    atomic_clear(&slot->run_behavior_batch.ack);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    slot->position_state_handle = 0;
+    slot->position_events_subscribe_params.value_handle = 0;
+    slot->position_events_seq_valid = false;
+    slot->clock = (struct peripheral_clock){0};
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     slot->update_hid_indicators = 0;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    slot->db_hash_valid = false;
+    slot->handles_from_cache = false;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
 
     return 0;
 }
@@ -178,22 +263,10 @@ int confirm_peripheral_slot_conn(struct bt_conn *conn) {
     }
 
     peripherals[idx].state = PERIPHERAL_SLOT_STATE_CONNECTED;
-    return 0;
+    return zmk_split_transport_central_peripheral_status_changed(&bt_central_transport, idx, true);
 }
 
 #if ZMK_KEYMAP_HAS_SENSORS
-K_MSGQ_DEFINE(peripheral_sensor_event_msgq, sizeof(struct zmk_sensor_event),
-              CONFIG_ZMK_SPLIT_BLE_CENTRAL_POSITION_QUEUE_SIZE, 4);
-
-void peripheral_sensor_event_work_callback(struct k_work *work) {
-    struct zmk_sensor_event ev;
-    while (k_msgq_get(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT) == 0) {
-        LOG_DBG("Trigger sensor change for %d", ev.sensor_index);
-        raise_zmk_sensor_event(ev);
-    }
-}
-
-K_WORK_DEFINE(peripheral_sensor_event_work, peripheral_sensor_event_work_callback);
 
 static uint8_t split_central_sensor_notify_func(struct bt_conn *conn,
                                                 struct bt_gatt_subscribe_params *params,
@@ -213,20 +286,72 @@ static uint8_t split_central_sensor_notify_func(struct bt_conn *conn,
 
     struct sensor_event sensor_event;
     memcpy(&sensor_event, data, MIN(length, sizeof(sensor_event)));
-    struct zmk_sensor_event ev = {
-        .sensor_index = sensor_event.sensor_index,
-        .channel_data_size = MIN(sensor_event.channel_data_size, ZMK_SENSOR_EVENT_MAX_CHANNELS),
-        .timestamp = k_uptime_get()};
-
-    memcpy(ev.channel_data, sensor_event.channel_data,
-           sizeof(struct zmk_sensor_channel_data) * sensor_event.channel_data_size);
-    k_msgq_put(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_sensor_event_work);
+    struct zmk_split_transport_peripheral_event ev = {
+        .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT,
+        .data.sensor_event =
+            {
+                .sensor_index = sensor_event.sensor_index,
+                .channel_data_size =
+                    MIN(sensor_event.channel_data_size, ZMK_SENSOR_EVENT_MAX_CHANNELS),
+            },
+    };
+
+    memcpy(ev.data.sensor_event.channel_data, sensor_event.channel_data,
+           sizeof(struct zmk_sensor_channel_data) * ev.data.sensor_event.channel_data_size);
+    zmk_split_transport_central_peripheral_event_handler(&bt_central_transport,
+                                                         peripheral_slot_index_for_conn(conn), ev);
 
     return BT_GATT_ITER_CONTINUE;
 }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+static void split_central_queue_position_event(struct bt_conn *conn, uint32_t position,
+                                               bool pressed, int64_t timestamp) {
+    struct zmk_split_transport_peripheral_event ev = {
+        .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+        .data.key_position_event =
+            {
+                .position = position,
+                .pressed = pressed,
+                .timestamp = timestamp,
+            },
+    };
+
+    zmk_split_transport_central_peripheral_event_handler(&bt_central_transport,
+                                                         peripheral_slot_index_for_conn(conn), ev);
+}
+
+// Applies `len` bytes of position state bitmap starting at byte `offset`. Bytes beyond the
+// positions of our keymap are ignored.
+static void split_central_apply_position_state(struct bt_conn *conn, struct peripheral_slot *slot,
+                                               size_t offset, const uint8_t *data, size_t len) {
+    if (offset >= POSITION_STATE_DATA_LEN) {
+        return;
+    }
+
+    size_t end = MIN(offset + len, POSITION_STATE_DATA_LEN);
+
+    for (size_t i = offset; i < end; i++) {
+        slot->changed_positions[i] = data[i - offset] ^ slot->position_state[i];
+        slot->position_state[i] = data[i - offset];
+        LOG_DBG("data: %d", slot->position_state[i]);
+    }
+
+    for (size_t i = offset; i < end; i++) {
+        if (!slot->changed_positions[i]) {
+            continue;
+        }
+
+        for (int j = 0; j < 8; j++) {
+            if (slot->changed_positions[i] & BIT(j)) {
+                uint32_t position = (i * 8) + j;
+                bool pressed = slot->position_state[i] & BIT(j);
+                split_central_queue_position_event(conn, position, pressed, k_uptime_get());
+            }
+        }
+    }
+}
+
 static uint8_t split_central_notify_func(struct bt_conn *conn,
                                          struct bt_gatt_subscribe_params *params, const void *data,
                                          uint16_t length) {
@@ -245,62 +370,194 @@ static uint8_t split_central_notify_func(struct bt_conn *conn,
 
     LOG_DBG("[NOTIFICATION] data %p length %u", data, length);
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        slot->changed_positions[i] = ((uint8_t *)data)[i] ^ slot->position_state[i];
-        slot->position_state[i] = ((uint8_t *)data)[i];
-        LOG_DBG("data: %d", slot->position_state[i]);
+    split_central_apply_position_state(conn, slot, 0, data, length);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+static uint8_t split_central_position_state_read_func(struct bt_conn *conn, uint8_t err,
+                                                      struct bt_gatt_read_params *params,
+                                                      const void *data, uint16_t length) {
+    if (err > 0) {
+        LOG_ERR("Error during reading peripheral position state: %u", err);
+        return BT_GATT_ITER_STOP;
     }
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->changed_positions[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                bool pressed = slot->position_state[i] & BIT(j);
-                struct zmk_position_state_changed ev = {.source =
-                                                            peripheral_slot_index_for_conn(conn),
-                                                        .position = position,
-                                                        .state = pressed,
-                                                        .timestamp = k_uptime_get()};
-
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
-        }
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (!data) {
+        LOG_DBG("[READ COMPLETED]");
+        return BT_GATT_ITER_STOP;
     }
 
+    // Large bitmaps arrive in several parts, the offset being that of the current part.
+    split_central_apply_position_state(conn, slot, params->single.offset, data, length);
+
     return BT_GATT_ITER_CONTINUE;
 }
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+static void split_central_request_position_state(struct bt_conn *conn,
+                                                 struct peripheral_slot *slot) {
+    if (!slot->position_state_handle) {
+        return;
+    }
 
-static uint8_t peripheral_battery_levels[ZMK_SPLIT_BLE_PERIPHERAL_COUNT] = {0};
+    slot->position_state_read_params.func = split_central_position_state_read_func;
+    slot->position_state_read_params.handle_count = 1;
+    slot->position_state_read_params.single.handle = slot->position_state_handle;
+    slot->position_state_read_params.single.offset = 0;
 
-int zmk_split_get_peripheral_battery_level(uint8_t source, uint8_t *level) {
-    if (source >= ARRAY_SIZE(peripheral_battery_levels)) {
-        return -EINVAL;
+    int err = bt_gatt_read(conn, &slot->position_state_read_params);
+    if (err < 0) {
+        LOG_ERR("Failed to read peripheral position state (err %d)", err);
     }
+}
 
-    if (peripherals[source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
-        return -ENOTCONN;
+// Converts a 32-bit peripheral timestamp to the full peripheral uptime, assuming it lies close to
+// the time currently expected from the clock offset.
+static int64_t split_central_peripheral_time(const struct peripheral_clock *clock,
+                                             uint32_t timestamp, int64_t now) {
+    if (!clock->synced) {
+        return timestamp;
     }
 
-    *level = peripheral_battery_levels[source];
-    return 0;
+    int64_t expected = now - clock->offset;
+    return expected + (int32_t)(timestamp - (uint32_t)expected);
+}
+
+static void split_central_update_clock(struct peripheral_clock *clock, int64_t peripheral_time,
+                                       int64_t now) {
+    int64_t offset = now - peripheral_time;
+
+    if (!clock->synced || offset < clock->offset) {
+        clock->offset = offset;
+        clock->synced = true;
+    }
+
+    if (clock->window_samples == 0 || offset < clock->window_offset) {
+        clock->window_offset = offset;
+    }
+
+    if (++clock->window_samples >= PERIPHERAL_CLOCK_SYNC_WINDOW) {
+        clock->offset = clock->window_offset;
+        clock->window_samples = 0;
+    }
 }
 
-K_MSGQ_DEFINE(peripheral_batt_lvl_msgq, sizeof(struct zmk_peripheral_battery_state_changed),
-              CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_QUEUE_SIZE, 4);
+static void split_central_apply_position_event(struct bt_conn *conn, struct peripheral_slot *slot,
+                                               const struct zmk_split_position_event *event,
+                                               int64_t timestamp) {
+    uint16_t state_age = sys_le16_to_cpu(event->state_age);
+    bool pressed = (state_age & ZMK_SPLIT_POSITION_EVENT_PRESSED) != 0;
+    uint16_t position = sys_le16_to_cpu(event->position);
 
-void peripheral_batt_lvl_change_callback(struct k_work *work) {
-    struct zmk_peripheral_battery_state_changed ev;
-    while (k_msgq_get(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT) == 0) {
-        LOG_DBG("Triggering peripheral battery level change %u", ev.state_of_charge);
-        peripheral_battery_levels[ev.source] = ev.state_of_charge;
-        raise_zmk_peripheral_battery_state_changed(ev);
+    if (position >= POSITION_STATE_DATA_LEN * 8) {
+        LOG_WRN("Ignoring event for out of range position %d", position);
+        return;
+    }
+
+    // Events already reflected in our state (e.g. sent before a resync) are dropped.
+    if (((slot->position_state[position / 8] & BIT(position % 8)) != 0) == pressed) {
+        return;
     }
+
+    WRITE_BIT(slot->position_state[position / 8], position % 8, pressed);
+    split_central_queue_position_event(conn, position, pressed,
+                                       timestamp - (state_age & ZMK_SPLIT_POSITION_EVENT_AGE_MASK));
 }
 
-K_WORK_DEFINE(peripheral_batt_lvl_work, peripheral_batt_lvl_change_callback);
+static uint8_t split_central_position_events_notify_func(struct bt_conn *conn,
+                                                         struct bt_gatt_subscribe_params *params,
+                                                         const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (slot == NULL) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("[POSITION EVENTS NOTIFICATION] data %p length %u", data, length);
+
+    const struct zmk_split_position_events_header *header = data;
+    const uint8_t *payload = (const uint8_t *)data + sizeof(*header);
+
+    if (length < sizeof(*header)) {
+        LOG_WRN("Ignoring position events notify with insufficient data length (%d)", length);
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    length -= sizeof(*header);
+
+    bool full_state = (header->flags & ZMK_SPLIT_POSITION_EVENTS_FLAG_FULL_STATE) != 0;
+    bool lost = slot->position_events_seq_valid && header->seq != slot->position_events_seq;
+
+    slot->position_events_seq = header->seq + 1;
+    slot->position_events_seq_valid = true;
+
+    int64_t now = k_uptime_get();
+    int64_t peripheral_time =
+        split_central_peripheral_time(&slot->clock, sys_le32_to_cpu(header->timestamp), now);
+
+    split_central_update_clock(&slot->clock, peripheral_time, now);
+
+    // Peripheral timestamps mapped onto our clock, never later than now.
+    int64_t timestamp = MIN(peripheral_time + slot->clock.offset, now);
+
+    if (full_state) {
+        const struct zmk_split_position_state_chunk *chunk =
+            (const struct zmk_split_position_state_chunk *)payload;
+
+        if (length < sizeof(*chunk)) {
+            LOG_WRN("Ignoring full position state with insufficient data length (%d)", length);
+            return BT_GATT_ITER_CONTINUE;
+        }
+
+        split_central_apply_position_state(conn, slot, sys_le16_to_cpu(chunk->offset),
+                                           chunk->data, length - sizeof(*chunk));
+    } else {
+        for (size_t i = 0; i + sizeof(struct zmk_split_position_event) <= length;
+             i += sizeof(struct zmk_split_position_event)) {
+            split_central_apply_position_event(
+                conn, slot, (const struct zmk_split_position_event *)&payload[i], timestamp);
+        }
+    }
+
+    if (lost) {
+        LOG_WRN("Missed position events from peripheral, reading full position state");
+        split_central_request_position_state(conn, slot);
+    }
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+
+static void split_central_report_battery_level(struct bt_conn *conn, uint8_t battery_level) {
+    LOG_DBG("Battery level: %u", battery_level);
+
+    struct zmk_split_transport_peripheral_event ev = {
+        .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT,
+        .data.battery_event = {.level = battery_level},
+    };
+
+    zmk_split_transport_central_peripheral_event_handler(&bt_central_transport,
+                                                         peripheral_slot_index_for_conn(conn), ev);
+}
 
 static uint8_t split_central_battery_level_notify_func(struct bt_conn *conn,
                                                        struct bt_gatt_subscribe_params *params,
@@ -324,12 +581,7 @@ static uint8_t split_central_battery_level_notify_func(struct bt_conn *conn,
     }
 
     LOG_DBG("[BATTERY LEVEL NOTIFICATION] data %p length %u", data, length);
-    uint8_t battery_level = ((uint8_t *)data)[0];
-    LOG_DBG("Battery level: %u", battery_level);
-    struct zmk_peripheral_battery_state_changed ev = {
-        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
-    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_batt_lvl_work);
+    split_central_report_battery_level(conn, ((uint8_t *)data)[0]);
 
     return BT_GATT_ITER_CONTINUE;
 }
@@ -361,18 +613,20 @@ static uint8_t split_central_battery_level_read_func(struct bt_conn *conn, uint8
         return BT_GATT_ITER_CONTINUE;
     }
 
-    uint8_t battery_level = ((uint8_t *)data)[0];
-
-    LOG_DBG("Battery level: %u", battery_level);
-
-    struct zmk_peripheral_battery_state_changed ev = {
-        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
-    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_batt_lvl_work);
+    split_central_report_battery_level(conn, ((uint8_t *)data)[0]);
 
     return BT_GATT_ITER_CONTINUE;
 }
 
+static void split_central_read_battery_level(struct bt_conn *conn, struct peripheral_slot *slot,
+                                             uint16_t value_handle) {
+    slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
+    slot->batt_lvl_read_params.handle_count = 1;
+    slot->batt_lvl_read_params.single.handle = value_handle;
+    slot->batt_lvl_read_params.single.offset = 0;
+    bt_gatt_read(conn, &slot->batt_lvl_read_params);
+}
+
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
 
 static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscribe_params *params) {
@@ -392,11 +646,201 @@ static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscrib
     return err;
 }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static bool handle_cache_complete(const struct peripheral_handle_cache *cache) {
+    bool complete = cache->run_behavior;
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    complete = complete && ((cache->position_events && cache->position_events_ccc) ||
+                            (cache->position_state && cache->position_state_ccc));
+#else
+    complete = complete && cache->position_state && cache->position_state_ccc;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    complete = complete && cache->run_behavior_batch && cache->run_behavior_batch_ccc;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+#if ZMK_KEYMAP_HAS_SENSORS
+    complete = complete && cache->sensor_state && cache->sensor_state_ccc;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    complete = complete && cache->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    complete = complete && cache->batt_lvl && cache->batt_lvl_ccc;
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+    return complete;
+}
+
+static void split_central_fill_handle_cache(const struct peripheral_slot *slot,
+                                            struct peripheral_handle_cache *cache) {
+    *cache = (struct peripheral_handle_cache){0};
+
+    memcpy(cache->db_hash, slot->db_hash, sizeof(cache->db_hash));
+    cache->run_behavior = slot->run_behavior_handle;
+    cache->position_state = slot->subscribe_params.value_handle;
+    cache->position_state_ccc = slot->subscribe_params.ccc_handle;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    cache->run_behavior_batch = slot->run_behavior_batch.handle;
+    cache->run_behavior_batch_ccc = slot->run_behavior_batch.subscribe_params.ccc_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    // The position state is also read after missed position events, even when not subscribed.
+    cache->position_state = slot->position_state_handle;
+    cache->position_events = slot->position_events_subscribe_params.value_handle;
+    cache->position_events_ccc = slot->position_events_subscribe_params.ccc_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+#if ZMK_KEYMAP_HAS_SENSORS
+    cache->sensor_state = slot->sensor_subscribe_params.value_handle;
+    cache->sensor_state_ccc = slot->sensor_subscribe_params.ccc_handle;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    cache->update_hid_indicators = slot->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    cache->batt_lvl = slot->batt_lvl_subscribe_params.value_handle;
+    cache->batt_lvl_ccc = slot->batt_lvl_subscribe_params.ccc_handle;
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+}
+
+static void split_central_save_handles_callback(struct k_work *work) {
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        struct peripheral_slot *slot = &peripherals[i];
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED || !slot->db_hash_valid ||
+            slot->handles_from_cache) {
+            continue;
+        }
+
+        struct peripheral_handle_cache cache;
+        split_central_fill_handle_cache(slot, &cache);
+
+        if (!handle_cache_complete(&cache) ||
+            memcmp(&cache, &handle_caches[i], sizeof(cache)) == 0) {
+            continue;
+        }
+
+        handle_caches[i] = cache;
+
+        char setting_name[32];
+        sprintf(setting_name, "ble_central/handles/%d", i);
+
+        int err = settings_save_one(setting_name, &cache, sizeof(cache));
+        if (err < 0) {
+            LOG_ERR("Failed to save handles for peripheral %d (err %d)", i, err);
+        }
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(split_central_save_handles_work,
+                               split_central_save_handles_callback);
+
+static void split_central_forget_handles(int index) {
+    handle_caches[index] = (struct peripheral_handle_cache){0};
+
+    char setting_name[32];
+    sprintf(setting_name, "ble_central/handles/%d", index);
+
+    int err = settings_delete(setting_name);
+    if (err < 0) {
+        LOG_ERR("Failed to delete handles for peripheral %d (err %d)", index, err);
+    }
+}
+
+static void split_central_subscribe_cb(struct bt_conn *conn, uint8_t err,
+                                       struct bt_gatt_subscribe_params *params) {
+    int idx = peripheral_slot_index_for_conn(conn);
+    if (idx < 0) {
+        return;
+    }
+
+    struct peripheral_slot *slot = &peripherals[idx];
+
+    if (err) {
+        LOG_ERR("Subscribing to handle %d failed (err %d)", params->value_handle, err);
+
+        if (slot->handles_from_cache) {
+            // The cached handles don't match the peripheral after all. Start over and rediscover.
+            split_central_forget_handles(idx);
+            bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        }
+        return;
+    }
+
+    if (!slot->handles_from_cache) {
+        k_work_reschedule(&split_central_save_handles_work,
+                          K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+// Subscribes to notifications of the given characteristic. Without a known CCC handle, it is
+// discovered in the remainder of the handle range being discovered.
+static int split_central_subscribe_handle(struct bt_conn *conn, struct peripheral_slot *slot,
+                                          struct bt_gatt_subscribe_params *params,
+                                          uint16_t value_handle, uint16_t ccc_handle,
+                                          bt_gatt_notify_func_t notify) {
+    params->ccc_handle = ccc_handle;
+    params->disc_params = &slot->sub_discover_params;
+    params->end_handle = slot->discover_params.end_handle;
+    params->value_handle = value_handle;
+    params->notify = notify;
+    params->value = BT_GATT_CCC_NOTIFY;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    params->subscribe = split_central_subscribe_cb;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+    return split_central_subscribe(conn, params);
+}
+
+static void split_central_subscribe_position_state(struct bt_conn *conn,
+                                                   struct peripheral_slot *slot,
+                                                   uint16_t value_handle) {
+    split_central_subscribe_handle(conn, slot, &slot->subscribe_params, value_handle, 0,
+                                   split_central_notify_func);
+}
+
+static bool split_central_position_subscribed(const struct peripheral_slot *slot) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    if (slot->position_events_subscribe_params.value_handle) {
+        return true;
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+    return slot->subscribe_params.value_handle;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+static uint8_t split_central_run_behavior_ack_notify_func(struct bt_conn *conn,
+                                                          struct bt_gatt_subscribe_params *params,
+                                                          const void *data, uint16_t length);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+static void split_central_subscribe_position_state_fallback(struct bt_conn *conn) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL || split_central_position_subscribed(slot) || !slot->position_state_handle) {
+        return;
+    }
+
+    LOG_DBG("Peripheral does not support position events, using full position state");
+    split_central_subscribe_position_state(conn, slot, slot->position_state_handle);
+}
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
 static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
                                                  const struct bt_gatt_attr *attr,
                                                  struct bt_gatt_discover_params *params) {
     if (!attr) {
         LOG_DBG("Discover complete");
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+        split_central_subscribe_position_state_fallback(conn);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
         return BT_GATT_ITER_STOP;
     }
 
@@ -416,12 +860,21 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
 
     if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID)) == 0) {
         LOG_DBG("Found position state characteristic");
-        slot->subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->subscribe_params.notify = split_central_notify_func;
-        slot->subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        split_central_subscribe(conn, &slot->subscribe_params);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+        // Only subscribe to the full position state if the peripheral turns out not to support
+        // position events, once discovery completes.
+        slot->position_state_handle = bt_gatt_attr_value_handle(attr);
+#else
+        split_central_subscribe_position_state(conn, slot, bt_gatt_attr_value_handle(attr));
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    } else if (bt_uuid_cmp(chrc_uuid,
+                           BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID)) == 0) {
+        LOG_DBG("Found position events characteristic");
+        split_central_subscribe_handle(conn, slot, &slot->position_events_subscribe_params,
+                                       bt_gatt_attr_value_handle(attr), 0,
+                                       split_central_position_events_notify_func);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
 #if ZMK_KEYMAP_HAS_SENSORS
     } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_SENSOR_STATE_UUID)) ==
                0) {
@@ -429,12 +882,9 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         slot->discover_params.start_handle = attr->handle + 2;
         slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
 
-        slot->sensor_subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->sensor_subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->sensor_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->sensor_subscribe_params.notify = split_central_sensor_notify_func;
-        slot->sensor_subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        split_central_subscribe(conn, &slot->sensor_subscribe_params);
+        split_central_subscribe_handle(conn, slot, &slot->sensor_subscribe_params,
+                                       bt_gatt_attr_value_handle(attr), 0,
+                                       split_central_sensor_notify_func);
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
     } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID)) ==
                0) {
@@ -442,6 +892,16 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         slot->discover_params.uuid = NULL;
         slot->discover_params.start_handle = attr->handle + 2;
         slot->run_behavior_handle = bt_gatt_attr_value_handle(attr);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    } else if (bt_uuid_cmp(chrc_uuid,
+                           BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_BATCH_UUID)) == 0) {
+        LOG_DBG("Found run behavior batch characteristic");
+        struct run_behavior_batch *batch = &slot->run_behavior_batch;
+        split_central_subscribe_handle(conn, slot, &batch->subscribe_params,
+                                       bt_gatt_attr_value_handle(attr), 0,
+                                       split_central_run_behavior_ack_notify_func);
+        batch->handle = bt_gatt_attr_value_handle(attr);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                             BT_UUID_DECLARE_128(ZMK_SPLIT_BT_UPDATE_HID_INDICATORS_UUID))) {
@@ -452,22 +912,18 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
     } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                             BT_UUID_BAS_BATTERY_LEVEL)) {
         LOG_DBG("Found battery level characteristics");
-        slot->batt_lvl_subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->batt_lvl_subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->batt_lvl_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->batt_lvl_subscribe_params.notify = split_central_battery_level_notify_func;
-        slot->batt_lvl_subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        split_central_subscribe(conn, &slot->batt_lvl_subscribe_params);
-
-        slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
-        slot->batt_lvl_read_params.handle_count = 1;
-        slot->batt_lvl_read_params.single.handle = bt_gatt_attr_value_handle(attr);
-        slot->batt_lvl_read_params.single.offset = 0;
-        bt_gatt_read(conn, &slot->batt_lvl_read_params);
+        split_central_subscribe_handle(conn, slot, &slot->batt_lvl_subscribe_params,
+                                       bt_gatt_attr_value_handle(attr), 0,
+                                       split_central_battery_level_notify_func);
+        split_central_read_battery_level(conn, slot, bt_gatt_attr_value_handle(attr));
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
     }
 
-    bool subscribed = slot->run_behavior_handle && slot->subscribe_params.value_handle;
+    bool subscribed = slot->run_behavior_handle && split_central_position_subscribed(slot);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    subscribed = subscribed && slot->run_behavior_batch.handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
 
 #if ZMK_KEYMAP_HAS_SENSORS
     subscribed = subscribed && slot->sensor_subscribe_params.value_handle;
@@ -518,6 +974,117 @@ static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
     return BT_GATT_ITER_STOP;
 }
 
+static int split_central_discover(struct bt_conn *conn, struct peripheral_slot *slot) {
+    slot->discover_params.uuid = &split_service_uuid.uuid;
+    slot->discover_params.func = split_central_service_discovery_func;
+    slot->discover_params.start_handle = 0x0001;
+    slot->discover_params.end_handle = 0xffff;
+    slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
+
+    int err = bt_gatt_discover(conn, &slot->discover_params);
+    if (err) {
+        LOG_ERR("Discover failed(err %d)", err);
+    }
+
+    return err;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static void split_central_subscribe_cached(struct bt_conn *conn, struct peripheral_slot *slot,
+                                           const struct peripheral_handle_cache *cache) {
+    slot->handles_from_cache = true;
+    slot->run_behavior_handle = cache->run_behavior;
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    slot->run_behavior_batch.handle = cache->run_behavior_batch;
+    split_central_subscribe_handle(conn, slot, &slot->run_behavior_batch.subscribe_params,
+                                   cache->run_behavior_batch, cache->run_behavior_batch_ccc,
+                                   split_central_run_behavior_ack_notify_func);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    slot->position_state_handle = cache->position_state;
+    if (cache->position_events && cache->position_events_ccc) {
+        split_central_subscribe_handle(conn, slot, &slot->position_events_subscribe_params,
+                                       cache->position_events, cache->position_events_ccc,
+                                       split_central_position_events_notify_func);
+    } else {
+        split_central_subscribe_handle(conn, slot, &slot->subscribe_params, cache->position_state,
+                                       cache->position_state_ccc, split_central_notify_func);
+    }
+#else
+    split_central_subscribe_handle(conn, slot, &slot->subscribe_params, cache->position_state,
+                                   cache->position_state_ccc, split_central_notify_func);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+#if ZMK_KEYMAP_HAS_SENSORS
+    split_central_subscribe_handle(conn, slot, &slot->sensor_subscribe_params, cache->sensor_state,
+                                   cache->sensor_state_ccc, split_central_sensor_notify_func);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    slot->update_hid_indicators = cache->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    split_central_subscribe_handle(conn, slot, &slot->batt_lvl_subscribe_params, cache->batt_lvl,
+                                   cache->batt_lvl_ccc, split_central_battery_level_notify_func);
+    split_central_read_battery_level(conn, slot, cache->batt_lvl);
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+}
+
+static uint8_t split_central_db_hash_read_func(struct bt_conn *conn, uint8_t err,
+                                               struct bt_gatt_read_params *params,
+                                               const void *data, uint16_t length) {
+    int idx = peripheral_slot_index_for_conn(conn);
+    if (idx < 0) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_slot *slot = &peripherals[idx];
+
+    // Peripherals without GATT caching have no database hash, so their handles can't be cached.
+    if (err || !data || length != sizeof(slot->db_hash)) {
+        LOG_DBG("No database hash read from peripheral %d (err %d)", idx, err);
+        split_central_discover(conn, slot);
+        return BT_GATT_ITER_STOP;
+    }
+
+    memcpy(slot->db_hash, data, sizeof(slot->db_hash));
+    slot->db_hash_valid = true;
+
+    const struct peripheral_handle_cache *cache = &handle_caches[idx];
+    if (handle_cache_complete(cache) &&
+        memcmp(cache->db_hash, slot->db_hash, sizeof(slot->db_hash)) == 0) {
+        LOG_DBG("Using cached handles for peripheral %d", idx);
+        split_central_subscribe_cached(conn, slot, cache);
+    } else {
+        split_central_discover(conn, slot);
+    }
+
+    return BT_GATT_ITER_STOP;
+}
+
+static int split_central_read_db_hash(struct bt_conn *conn, struct peripheral_slot *slot) {
+    slot->db_hash_read_params.func = split_central_db_hash_read_func;
+    slot->db_hash_read_params.handle_count = 0;
+    slot->db_hash_read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+    slot->db_hash_read_params.by_uuid.start_handle = 0x0001;
+    slot->db_hash_read_params.by_uuid.end_handle = 0xffff;
+
+    int err = bt_gatt_read(conn, &slot->db_hash_read_params);
+    if (err) {
+        LOG_WRN("Failed to read database hash (err %d)", err);
+        return split_central_discover(conn, slot);
+    }
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
 static void split_central_process_connection(struct bt_conn *conn) {
     int err;
 
@@ -529,16 +1096,13 @@ static void split_central_process_connection(struct bt_conn *conn) {
         return;
     }
 
-    if (!slot->subscribe_params.value_handle) {
-        slot->discover_params.uuid = &split_service_uuid.uuid;
-        slot->discover_params.func = split_central_service_discovery_func;
-        slot->discover_params.start_handle = 0x0001;
-        slot->discover_params.end_handle = 0xffff;
-        slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
-
-        err = bt_gatt_discover(slot->conn, &slot->discover_params);
+    if (!split_central_position_subscribed(slot)) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+        err = split_central_read_db_hash(conn, slot);
+#else
+        err = split_central_discover(conn, slot);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
         if (err) {
-            LOG_ERR("Discover failed(err %d)", err);
             return;
         }
     }
@@ -567,6 +1131,24 @@ static int stop_scanning(void) {
     return 0;
 }
 
+// The supervision timeout is in 10 ms units and the connection interval in 1.25 ms units, the
+// timeout must be longer than twice the effective interval including skipped connection events.
+BUILD_ASSERT(CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT * 4 >
+                 (1 + CONFIG_ZMK_SPLIT_BLE_IDLE_PREF_LATENCY) * CONFIG_ZMK_SPLIT_BLE_PREF_INT,
+             "Split idle latency is too high for the supervision timeout");
+
+static struct bt_le_conn_param split_central_conn_param(void) {
+    // Peripherals can always send key events at the next connection event, so only the central
+    // waits longer for the peripheral to listen while the latency is raised.
+    uint16_t latency = zmk_activity_get_state() == ZMK_ACTIVITY_ACTIVE
+                           ? CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY
+                           : CONFIG_ZMK_SPLIT_BLE_IDLE_PREF_LATENCY;
+
+    return (struct bt_le_conn_param)BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT, latency,
+        CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT);
+}
+
 static bool split_central_eir_found(const bt_addr_le_t *addr) {
     LOG_DBG("Found the split service");
 
@@ -587,10 +1169,8 @@ static bool split_central_eir_found(const bt_addr_le_t *addr) {
     }
 
     LOG_DBG("Initiating new connection");
-    struct bt_le_conn_param *param =
-        BT_LE_CONN_PARAM(CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT,
-                         CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT);
-    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, param, &slot->conn);
+    struct bt_le_conn_param param = split_central_conn_param();
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, &param, &slot->conn);
     if (err < 0) {
         LOG_ERR("Create conn failed (err %d) (create conn? 0x%04x)", err, BT_HCI_OP_LE_CREATE_CONN);
         release_peripheral_slot(slot_idx);
@@ -723,13 +1303,6 @@ static void split_central_disconnected(struct bt_conn *conn, uint8_t reason) {
 
     LOG_DBG("Disconnected: %s (reason %d)", addr, reason);
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
-    struct zmk_peripheral_battery_state_changed ev = {
-        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = 0};
-    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_batt_lvl_work);
-#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
-
     err = release_peripheral_slot_for_conn(conn);
 
     if (err < 0) {
@@ -752,12 +1325,134 @@ struct k_work_q split_central_split_run_q;
 struct zmk_split_run_behavior_payload_wrapper {
     uint8_t source;
     struct zmk_split_run_behavior_payload payload;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    bool batched;
+    zmk_behavior_local_id_t local_id;
+    // The payload position only has 8 bits.
+    uint16_t position;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
 };
 
 K_MSGQ_DEFINE(zmk_split_central_split_run_msgq,
               sizeof(struct zmk_split_run_behavior_payload_wrapper),
               CONFIG_ZMK_SPLIT_BLE_CENTRAL_SPLIT_RUN_QUEUE_SIZE, 4);
 
+void split_central_split_run_callback(struct k_work *work);
+
+K_WORK_DEFINE(split_central_split_run_work, split_central_split_run_callback);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+K_WORK_DELAYABLE_DEFINE(split_central_split_run_retry_work, split_central_split_run_callback);
+
+static uint8_t split_central_run_behavior_ack_notify_func(struct bt_conn *conn,
+                                                          struct bt_gatt_subscribe_params *params,
+                                                          const void *data, uint16_t length) {
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot == NULL || length < sizeof(uint8_t)) {
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    atomic_set(&slot->run_behavior_batch.ack,
+               RUN_BEHAVIOR_BATCH_ACK_VALID | ((const uint8_t *)data)[0]);
+    k_work_submit_to_queue(&split_central_split_run_q, &split_central_split_run_work);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static void split_central_drop_batch_items(struct run_behavior_batch *batch, uint8_t count) {
+    memmove(batch->items, &batch->items[count], (batch->count - count) * sizeof(batch->items[0]));
+    batch->seq += count;
+    batch->count -= count;
+    batch->sent = batch->sent > count ? batch->sent - count : 0;
+}
+
+static void
+split_central_queue_batch_item(struct run_behavior_batch *batch,
+                               const struct zmk_split_run_behavior_payload_wrapper *wrapper) {
+    if (batch->count == ARRAY_SIZE(batch->items)) {
+        LOG_WRN("Behavior invocation queue full, dropping the oldest invocation");
+        split_central_drop_batch_items(batch, 1);
+    }
+
+    batch->items[batch->count++] = (struct zmk_split_run_behavior_batch_item){
+        .local_id = sys_cpu_to_le16(wrapper->local_id),
+        .position = sys_cpu_to_le16(wrapper->position),
+        .state = wrapper->payload.data.state,
+        .param1 = sys_cpu_to_le32(wrapper->payload.data.param1),
+        .param2 = sys_cpu_to_le32(wrapper->payload.data.param2),
+    };
+}
+
+static void split_central_apply_batch_ack(struct run_behavior_batch *batch) {
+    atomic_val_t ack = atomic_clear(&batch->ack);
+    if (!(ack & RUN_BEHAVIOR_BATCH_ACK_VALID)) {
+        return;
+    }
+
+    uint8_t acked = (uint8_t)ack - batch->seq;
+
+    // Acknowledgements for invocations that were already dropped or never sent are stale.
+    if (acked > batch->sent) {
+        LOG_DBG("Ignoring stale acknowledgement %d", (uint8_t)ack);
+        return;
+    }
+
+    split_central_drop_batch_items(batch, acked);
+    batch->sent_at = k_uptime_get();
+}
+
+static void split_central_send_batch(struct peripheral_slot *slot) {
+    struct run_behavior_batch *batch = &slot->run_behavior_batch;
+    uint8_t buf[RUN_BEHAVIOR_BATCH_WRITE_MAX_LEN];
+    struct zmk_split_run_behavior_batch_header *header =
+        (struct zmk_split_run_behavior_batch_header *)buf;
+    struct zmk_split_run_behavior_batch_item *items =
+        (struct zmk_split_run_behavior_batch_item *)&buf[sizeof(*header)];
+    size_t write_len = MIN(bt_gatt_get_mtu(slot->conn) - 3, sizeof(buf));
+    size_t max_count = (write_len - sizeof(*header)) / sizeof(*items);
+
+    split_central_apply_batch_ack(batch);
+
+    if (batch->sent > 0 &&
+        k_uptime_get() - batch->sent_at >=
+            CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATCHED_BEHAVIORS_RETRY_TIMEOUT) {
+        LOG_WRN("Behavior invocations not acknowledged in time, sending them again");
+        batch->sent = 0;
+    }
+
+    while (batch->sent < batch->count) {
+        size_t count = MIN(batch->count - batch->sent, max_count);
+
+        header->seq = batch->seq + batch->sent;
+        memcpy(items, &batch->items[batch->sent], count * sizeof(*items));
+
+        int err = bt_gatt_write_without_response(slot->conn, batch->handle, buf,
+                                                 sizeof(*header) + count * sizeof(*items), true);
+        if (err) {
+            LOG_ERR("Failed to write the behavior batch characteristic (err %d)", err);
+            break;
+        }
+
+        batch->sent += count;
+        batch->sent_at = k_uptime_get();
+    }
+
+    if (batch->count > 0) {
+        k_work_reschedule_for_queue(
+            &split_central_split_run_q, &split_central_split_run_retry_work,
+            K_MSEC(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATCHED_BEHAVIORS_RETRY_TIMEOUT));
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
 void split_central_split_run_callback(struct k_work *work) {
     struct zmk_split_run_behavior_payload_wrapper payload_wrapper;
 
@@ -768,6 +1463,16 @@ void split_central_split_run_callback(struct k_work *work) {
             LOG_ERR("Source not connected");
             continue;
         }
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+        if (payload_wrapper.batched) {
+            // Sent together with everything else queued for the peripheral below.
+            split_central_queue_batch_item(&peripherals[payload_wrapper.source].run_behavior_batch,
+                                           &payload_wrapper);
+            continue;
+        }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
         if (!peripherals[payload_wrapper.source].run_behavior_handle) {
             LOG_ERR("Run behavior handle not found");
             continue;
@@ -782,9 +1487,16 @@ void split_central_split_run_callback(struct k_work *work) {
             LOG_ERR("Failed to write the behavior characteristic (err %d)", err);
         }
     }
-}
 
-K_WORK_DEFINE(split_central_split_run_work, split_central_split_run_callback);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (peripherals[i].state == PERIPHERAL_SLOT_STATE_CONNECTED &&
+            peripherals[i].run_behavior_batch.handle) {
+            split_central_send_batch(&peripherals[i]);
+        }
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+}
 
 static int
 split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_payload_wrapper payload_wrapper) {
@@ -810,32 +1522,61 @@ split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_payload_wrapper p
     return 0;
 };
 
-int zmk_split_bt_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
-                                 struct zmk_behavior_binding_event event, bool state) {
-    struct zmk_split_run_behavior_payload payload = {.data = {
-                                                         .param1 = binding->param1,
-                                                         .param2 = binding->param2,
-                                                         .position = event.position,
-                                                         .state = state ? 1 : 0,
-                                                     }};
-    const size_t payload_dev_size = sizeof(payload.behavior_dev);
-    if (strlcpy(payload.behavior_dev, binding->behavior_dev, payload_dev_size) >=
-        payload_dev_size) {
+BUILD_ASSERT(ZMK_KEYMAP_LEN <= UINT16_MAX,
+             "Split run behavior batches only support 16-bit key positions");
+
+static int split_central_bt_invoke_behavior(uint8_t source,
+                                            const struct zmk_split_transport_central_command *cmd) {
+    struct zmk_split_run_behavior_payload_wrapper wrapper = {.source = source};
+    struct zmk_split_run_behavior_payload *payload = &wrapper.payload;
+
+    payload->data.param1 = cmd->data.invoke_behavior.param1;
+    payload->data.param2 = cmd->data.invoke_behavior.param2;
+    payload->data.position = cmd->data.invoke_behavior.position;
+    payload->data.state = cmd->data.invoke_behavior.state ? 1 : 0;
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    if (peripherals[source].run_behavior_batch.handle) {
+        wrapper.position = cmd->data.invoke_behavior.position;
+        wrapper.local_id = zmk_behavior_get_local_id(cmd->data.invoke_behavior.behavior_dev);
+        if (wrapper.local_id == UINT16_MAX) {
+            LOG_ERR("No local ID found for behavior %s", cmd->data.invoke_behavior.behavior_dev);
+            return -ENODEV;
+        }
+
+        wrapper.batched = true;
+        return split_bt_invoke_behavior_payload(wrapper);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+    if (cmd->data.invoke_behavior.position > UINT8_MAX) {
+        LOG_ERR("Can't invoke a peripheral behavior for position %d without batched behaviors",
+                cmd->data.invoke_behavior.position);
+        return -ENOTSUP;
+    }
+
+    const size_t behavior_dev_size = sizeof(payload->behavior_dev);
+    if (strlcpy(payload->behavior_dev, cmd->data.invoke_behavior.behavior_dev, behavior_dev_size) >=
+        behavior_dev_size) {
         LOG_ERR("Truncated behavior label %s to %s before invoking peripheral behavior",
-                binding->behavior_dev, payload.behavior_dev);
+                cmd->data.invoke_behavior.behavior_dev, payload->behavior_dev);
     }
 
-    struct zmk_split_run_behavior_payload_wrapper wrapper = {.source = source, .payload = payload};
     return split_bt_invoke_behavior_payload(wrapper);
 }
 
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
 static zmk_hid_indicators_t hid_indicators = 0;
+static atomic_t hid_indicators_pending;
 
 static void split_central_update_indicators_callback(struct k_work *work) {
     zmk_hid_indicators_t indicators = hid_indicators;
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (!atomic_test_and_clear_bit(&hid_indicators_pending, i)) {
+            continue;
+        }
+
         if (peripherals[i].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
             continue;
         }
@@ -859,13 +1600,71 @@ static void split_central_update_indicators_callback(struct k_work *work) {
 
 static K_WORK_DEFINE(split_central_update_indicators, split_central_update_indicators_callback);
 
-int zmk_split_bt_update_hid_indicator(zmk_hid_indicators_t indicators) {
+static int split_central_bt_update_hid_indicators(uint8_t source,
+                                                  zmk_hid_indicators_t indicators) {
     hid_indicators = indicators;
+    atomic_set_bit(&hid_indicators_pending, source);
     return k_work_submit_to_queue(&split_central_split_run_q, &split_central_update_indicators);
 }
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
+static int split_central_bt_send_command(uint8_t source,
+                                         struct zmk_split_transport_central_command cmd) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    if (peripherals[source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        return -ENOTCONN;
+    }
+
+    switch (cmd.type) {
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR:
+        return split_central_bt_invoke_behavior(source, &cmd);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS:
+        return split_central_bt_update_hid_indicators(source,
+                                                      cmd.data.set_hid_indicators.indicators);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static void split_central_update_conn_params_callback(struct k_work *work) {
+    struct bt_le_conn_param param = split_central_conn_param();
+
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (peripherals[i].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+            continue;
+        }
+
+        int err = bt_conn_le_param_update(peripherals[i].conn, &param);
+        if (err < 0 && err != -EALREADY) {
+            LOG_WRN("Failed to update connection parameters of peripheral %d (err %d)", i, err);
+        }
+    }
+}
+
+static K_WORK_DEFINE(split_central_update_conn_params, split_central_update_conn_params_callback);
+
+static int split_central_activity_listener(const zmk_event_t *eh) {
+    // Updating the parameters waits on the controller, keep that out of the event handling.
+    k_work_submit_to_queue(&split_central_split_run_q, &split_central_update_conn_params);
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_central_activity, split_central_activity_listener);
+ZMK_SUBSCRIPTION(split_central_activity, zmk_activity_state_changed);
+
+static const struct zmk_split_transport_central_api bt_central_api = {
+    .send_command = split_central_bt_send_command,
+};
+
+ZMK_SPLIT_TRANSPORT_CENTRAL_REGISTER(bt_central_transport, &bt_central_api);
+
 static int finish_init() {
     return IS_ENABLED(CONFIG_ZMK_BLE_CLEAR_BONDS_ON_START) ? 0 : start_scanning();
 }
@@ -874,6 +1673,27 @@ static int finish_init() {
 
 static int central_ble_handle_set(const char *name, size_t len, settings_read_cb read_cb,
                                   void *cb_arg) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    const char *next;
+
+    if (settings_name_steq(name, "handles", &next) && next) {
+        if (len != sizeof(struct peripheral_handle_cache)) {
+            return -EINVAL;
+        }
+
+        int i = atoi(next);
+        if (i < 0 || i >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+            LOG_ERR("Failed to store peripheral handles in memory");
+        } else {
+            int err = read_cb(cb_arg, &handle_caches[i], sizeof(handle_caches[i]));
+            if (err <= 0) {
+                LOG_ERR("Failed to handle peripheral handles from settings (err %d)", err);
+                return err;
+            }
+        }
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
     return 0;
 }
 
@@ -7,24 +7,27 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/types.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/init.h>
 
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
 
-#include <drivers/behavior.h>
 #include <zmk/behavior.h>
 #include <zmk/matrix.h>
 #include <zmk/split/bluetooth/uuid.h>
+#include <zmk/split/bluetooth/peripheral.h>
 #include <zmk/split/bluetooth/service.h>
-
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
-#include <zmk/events/hid_indicators_changed.h>
-#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#include <zmk/split/transport/peripheral.h>
 
 #include <zmk/events/sensor_event.h>
 #include <zmk/sensors.h>
@@ -43,13 +46,20 @@ static void split_svc_sensor_state_ccc(const struct bt_gatt_attr *attr, uint16_t
 }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
-#define POS_STATE_LEN 16
+K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
+
+struct k_work_q service_work_q;
 
-static uint8_t num_of_positions = ZMK_KEYMAP_LEN;
+#define POS_STATE_LEN ZMK_SPLIT_POS_STATE_LEN
+
+// The Number of Digitals descriptor is a single byte, larger keymaps report the maximum.
+static uint8_t num_of_positions = MIN(ZMK_KEYMAP_LEN, UINT8_MAX);
 static uint8_t position_state[POS_STATE_LEN];
 
 static struct zmk_split_run_behavior_payload behavior_run_payload;
 
+static const struct zmk_split_transport_peripheral bt_peripheral_transport;
+
 static ssize_t split_svc_pos_state(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                    void *buf, uint16_t len, uint16_t offset) {
     return bt_gatt_attr_read(conn, attrs, buf, len, offset, &position_state,
@@ -59,16 +69,24 @@ static ssize_t split_svc_pos_state(struct bt_conn *conn, const struct bt_gatt_at
 static ssize_t split_svc_run_behavior(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                       const void *buf, uint16_t len, uint16_t offset,
                                       uint8_t flags) {
+    static uint16_t received_len;
     struct zmk_split_run_behavior_payload *payload = attrs->user_data;
     uint16_t end_addr = offset + len;
 
     LOG_DBG("offset %d len %d", offset, len);
 
-    if (end_addr > sizeof(struct zmk_split_run_behavior_payload)) {
+    // A payload may arrive in several writes, each continuing where the last one ended. Anything
+    // else would run the behavior with data left over from an earlier payload.
+    if (offset != 0 && offset != received_len) {
         return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
     }
 
-    memcpy(payload + offset, buf, len);
+    if (end_addr > sizeof(struct zmk_split_run_behavior_payload)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    memcpy((uint8_t *)payload + offset, buf, len);
+    received_len = end_addr;
 
     // We run if:
     // 1: We've gotten all the position/state/param data.
@@ -77,30 +95,123 @@ static ssize_t split_svc_run_behavior(struct bt_conn *conn, const struct bt_gatt
         offsetof(struct zmk_split_run_behavior_payload, behavior_dev);
     if ((end_addr > sizeof(struct zmk_split_run_behavior_data)) &&
         payload->behavior_dev[end_addr - behavior_dev_offset - 1] == '\0') {
-        struct zmk_behavior_binding binding = {
-            .param1 = payload->data.param1,
-            .param2 = payload->data.param2,
-            .behavior_dev = payload->behavior_dev,
+        struct zmk_split_transport_central_command cmd = {
+            .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
+            .data.invoke_behavior =
+                {
+                    .behavior_dev = payload->behavior_dev,
+                    .param1 = payload->data.param1,
+                    .param2 = payload->data.param2,
+                    .position = payload->data.position,
+                    .state = payload->data.state > 0,
+                },
         };
-        LOG_DBG("%s with params %d %d: pressed? %d", binding.behavior_dev, binding.param1,
-                binding.param2, payload->data.state);
-        struct zmk_behavior_binding_event event = {.position = payload->data.position,
-                                                   .timestamp = k_uptime_get()};
-        int err;
-        if (payload->data.state > 0) {
-            err = behavior_keymap_binding_pressed(&binding, event);
-        } else {
-            err = behavior_keymap_binding_released(&binding, event);
+
+        zmk_split_transport_peripheral_command_handler(&bt_peripheral_transport, cmd);
+    }
+
+    return len;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
+static uint8_t run_behavior_batch_next_seq;
+static const struct bt_gatt_attr *run_behavior_batch_attr;
+
+// Acknowledgements are notified from the service work queue like the other notifications, rather
+// than from the write callback.
+static void send_run_behavior_batch_ack_callback(struct k_work *work) {
+    uint8_t next_seq = run_behavior_batch_next_seq;
+
+    int err = bt_gatt_notify(NULL, run_behavior_batch_attr, &next_seq, sizeof(next_seq));
+    if (err) {
+        LOG_DBG("Error notifying %d", err);
+    }
+}
+
+static K_WORK_DEFINE(run_behavior_batch_ack_work, send_run_behavior_batch_ack_callback);
+
+static void run_behavior_batch_item(const struct zmk_split_run_behavior_batch_item *item) {
+    zmk_behavior_local_id_t local_id = sys_le16_to_cpu(item->local_id);
+    const char *behavior_dev = zmk_behavior_find_behavior_name_from_local_id(local_id);
+
+    if (!behavior_dev) {
+        LOG_WRN("No behavior found for local ID %d", local_id);
+        return;
+    }
+
+    struct zmk_split_transport_central_command cmd = {
+        .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
+        .data.invoke_behavior =
+            {
+                .behavior_dev = behavior_dev,
+                .param1 = sys_le32_to_cpu(item->param1),
+                .param2 = sys_le32_to_cpu(item->param2),
+                .position = sys_le16_to_cpu(item->position),
+                .state = item->state > 0,
+            },
+    };
+
+    zmk_split_transport_peripheral_command_handler(&bt_peripheral_transport, cmd);
+}
+
+static ssize_t split_svc_run_behavior_batch(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                            const void *buf, uint16_t len, uint16_t offset,
+                                            uint8_t flags) {
+    const struct zmk_split_run_behavior_batch_header *header = buf;
+    const struct zmk_split_run_behavior_batch_item *items =
+        (const struct zmk_split_run_behavior_batch_item *)((const uint8_t *)buf + sizeof(*header));
+
+    if (offset != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    if (len < sizeof(*header) || (len - sizeof(*header)) % sizeof(*items) != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    size_t count = (len - sizeof(*header)) / sizeof(*items);
+
+    LOG_DBG("seq %d count %d", header->seq, count);
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t seq = header->seq + i;
+        int8_t gap = seq - run_behavior_batch_next_seq;
+
+        // Invocations the central sent again because their acknowledgement was late already ran.
+        if (gap < 0) {
+            continue;
         }
 
-        if (err) {
-            LOG_ERR("Failed to invoke behavior %s: %d", binding.behavior_dev, err);
+        if (gap > 0) {
+            LOG_WRN("Central dropped %d behavior invocations", gap);
         }
+
+        run_behavior_batch_item(&items[i]);
+        run_behavior_batch_next_seq = seq + 1;
     }
 
+    run_behavior_batch_attr = attr;
+    k_work_submit_to_queue(&service_work_q, &run_behavior_batch_ack_work);
+
     return len;
 }
 
+static void split_svc_run_behavior_batch_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("value %d", value);
+}
+
+static void split_svc_connected(struct bt_conn *conn, uint8_t err) {
+    // The central numbers behavior invocations from zero on every connection.
+    run_behavior_batch_next_seq = 0;
+}
+
+BT_CONN_CB_DEFINE(split_svc_conn_callbacks) = {
+    .connected = split_svc_connected,
+};
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+
 static ssize_t split_svc_num_of_positions(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                           void *buf, uint16_t len, uint16_t offset) {
     return bt_gatt_attr_read(conn, attrs, buf, len, offset, attrs->user_data, sizeof(uint8_t));
@@ -110,18 +221,14 @@ static void split_svc_pos_state_ccc(const struct bt_gatt_attr *attr, uint16_t va
     LOG_DBG("value %d", value);
 }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+static void split_svc_pos_events_ccc(const struct bt_gatt_attr *attr, uint16_t value);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
 static zmk_hid_indicators_t hid_indicators = 0;
 
-static void split_svc_update_indicators_callback(struct k_work *work) {
-    LOG_DBG("Raising HID indicators changed event: %x", hid_indicators);
-    raise_zmk_hid_indicators_changed(
-        (struct zmk_hid_indicators_changed){.indicators = hid_indicators});
-}
-
-static K_WORK_DEFINE(split_svc_update_indicators_work, split_svc_update_indicators_callback);
-
 static ssize_t split_svc_update_indicators(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                                            const void *buf, uint16_t len, uint16_t offset,
                                            uint8_t flags) {
@@ -131,7 +238,12 @@ static ssize_t split_svc_update_indicators(struct bt_conn *conn, const struct bt
 
     memcpy((uint8_t *)&hid_indicators + offset, buf, len);
 
-    k_work_submit(&split_svc_update_indicators_work);
+    struct zmk_split_transport_central_command cmd = {
+        .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS,
+        .data.set_hid_indicators = {.indicators = hid_indicators},
+    };
+
+    zmk_split_transport_peripheral_command_handler(&bt_peripheral_transport, cmd);
 
     return len;
 }
@@ -160,20 +272,55 @@ BT_GATT_SERVICE_DEFINE(
                            BT_GATT_CHRC_WRITE_WITHOUT_RESP, BT_GATT_PERM_WRITE_ENCRYPT, NULL,
                            split_svc_update_indicators, NULL),
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID),
+                           BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_NONE, NULL, NULL, NULL),
+    BT_GATT_CCC(split_svc_pos_events_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_BATCH_UUID),
+                           BT_GATT_CHRC_WRITE_WITHOUT_RESP | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_WRITE_ENCRYPT, NULL, split_svc_run_behavior_batch, NULL),
+    BT_GATT_CCC(split_svc_run_behavior_batch_ccc,
+                BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_BATCHED_BEHAVIORS)
 );
 
-K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
-
-struct k_work_q service_work_q;
-
 K_MSGQ_DEFINE(position_state_msgq, sizeof(char[POS_STATE_LEN]),
               CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
 
+#define POSITION_NOTIFY_DEFAULT_MTU 23
+
+static void position_notify_mtu_callback(struct bt_conn *conn, void *data) {
+    uint16_t *mtu = data;
+    uint16_t conn_mtu = bt_gatt_get_mtu(conn);
+
+    if (conn_mtu > 0) {
+        *mtu = MIN(*mtu, conn_mtu);
+    }
+}
+
+// Largest notification that fits the ATT MTU of every connection.
+static size_t position_notify_max_len(void) {
+    uint16_t mtu = UINT16_MAX;
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, position_notify_mtu_callback, &mtu);
+    if (mtu == UINT16_MAX) {
+        mtu = POSITION_NOTIFY_DEFAULT_MTU;
+    }
+
+    // Leave room for the ATT opcode and handle.
+    return mtu - 3;
+}
+
 void send_position_state_callback(struct k_work *work) {
     uint8_t state[POS_STATE_LEN];
 
     while (k_msgq_get(&position_state_msgq, &state, K_NO_WAIT) == 0) {
-        int err = bt_gatt_notify(NULL, &split_svc.attrs[1], &state, sizeof(state));
+        // Bitmaps longer than the MTU are truncated, only position events can carry every
+        // position of such large keymaps.
+        int err = bt_gatt_notify(NULL, &split_svc.attrs[1], &state,
+                                 MIN(sizeof(state), position_notify_max_len()));
         if (err) {
             LOG_DBG("Error notifying %d", err);
         }
@@ -203,16 +350,281 @@ int send_position_state() {
     return 0;
 }
 
-int zmk_split_bt_position_pressed(uint8_t position) {
-    WRITE_BIT(position_state[position / 8], position % 8, true);
-    return send_position_state();
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+// Position event notifications are sized from the ATT MTU of the connection, up to the largest
+// MTU the stack supports.
+#define POSITION_EVENTS_NOTIFY_MAX_LEN (CONFIG_BT_L2CAP_TX_MTU - 3)
+
+// Rough stack use of the notify path besides the notification buffer itself.
+#define POSITION_EVENTS_STACK_OVERHEAD 640
+
+BUILD_ASSERT(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE >=
+                 POSITION_EVENTS_NOTIFY_MAX_LEN + POSITION_EVENTS_STACK_OVERHEAD,
+             "CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE is too small for position event "
+             "notifications of CONFIG_BT_L2CAP_TX_MTU bytes");
+
+struct position_event_item {
+    int64_t timestamp;
+    // Uptime in ticks when the event was queued, to measure how long it waited to be sent.
+    int64_t queued_at;
+    uint32_t position;
+    bool state;
+};
+
+K_MSGQ_DEFINE(position_event_msgq, sizeof(struct position_event_item),
+              CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
+
+static const struct bt_gatt_attr *position_events_attr;
+static bool position_events_enabled;
+static atomic_t position_resync_pending;
+static uint8_t position_events_seq;
+static struct zmk_split_bt_peripheral_position_events_stats position_events_stats;
+
+static size_t position_events_notify_len(void) {
+    return MIN(position_notify_max_len(), POSITION_EVENTS_NOTIFY_MAX_LEN);
+}
+
+static size_t position_events_per_notify(void) {
+    return (position_events_notify_len() - sizeof(struct zmk_split_position_events_header)) /
+           sizeof(struct zmk_split_position_event);
+}
+
+static void notify_position_events(const uint8_t *buf, size_t len) {
+    // The sequence number advances even if the notification fails so the central can detect the
+    // gap and request the full state.
+    position_events_seq++;
+
+    int err = bt_gatt_notify(NULL, position_events_attr, buf, len);
+    if (err) {
+        LOG_DBG("Error notifying %d", err);
+    }
+}
+
+static void add_position_event(struct zmk_split_position_event *event,
+                               const struct position_event_item *item, int64_t now) {
+    uint16_t state_age = MIN(now - item->timestamp, ZMK_SPLIT_POSITION_EVENT_AGE_MASK);
+    if (item->state) {
+        state_age |= ZMK_SPLIT_POSITION_EVENT_PRESSED;
+    }
+
+    event->position = sys_cpu_to_le16(item->position);
+    event->state_age = sys_cpu_to_le16(state_age);
+
+    position_events_stats.total_delay_us +=
+        k_ticks_to_us_floor64(k_uptime_ticks() - item->queued_at);
+}
+
+static void send_position_events(uint8_t *buf, size_t count, int64_t now) {
+    struct zmk_split_position_events_header *header =
+        (struct zmk_split_position_events_header *)buf;
+
+    header->flags = 0;
+    header->seq = position_events_seq;
+    header->timestamp = sys_cpu_to_le32((uint32_t)now);
+
+    position_events_stats.events += count;
+    position_events_stats.notifications++;
+
+    notify_position_events(buf, sizeof(*header) + count * sizeof(struct zmk_split_position_event));
+}
+
+static void send_position_events_full_state(void) {
+    uint8_t buf[POSITION_EVENTS_NOTIFY_MAX_LEN];
+    struct zmk_split_position_events_header *header =
+        (struct zmk_split_position_events_header *)buf;
+    struct zmk_split_position_state_chunk *chunk =
+        (struct zmk_split_position_state_chunk *)&buf[sizeof(*header)];
+    size_t chunk_len = position_events_notify_len() - sizeof(*header) - sizeof(*chunk);
+
+    for (size_t offset = 0; offset < POS_STATE_LEN; offset += chunk_len) {
+        size_t len = MIN(chunk_len, POS_STATE_LEN - offset);
+
+        header->flags = ZMK_SPLIT_POSITION_EVENTS_FLAG_FULL_STATE;
+        header->seq = position_events_seq;
+        header->timestamp = sys_cpu_to_le32((uint32_t)k_uptime_get());
+        chunk->offset = sys_cpu_to_le16(offset);
+        memcpy(chunk->data, &position_state[offset], len);
+
+        notify_position_events(buf, sizeof(*header) + sizeof(*chunk) + len);
+    }
+}
+
+static void send_position_events_callback(struct k_work *work) {
+    uint8_t buf[POSITION_EVENTS_NOTIFY_MAX_LEN];
+    struct zmk_split_position_event *events =
+        (struct zmk_split_position_event *)&buf[sizeof(struct zmk_split_position_events_header)];
+    size_t max_count = position_events_per_notify();
+    size_t count = 0;
+    struct position_event_item item;
+    int64_t now = 0;
+
+    // Events go straight from the queue into the notification, so only one buffer of them is ever
+    // on the stack.
+    while (k_msgq_get(&position_event_msgq, &item, K_NO_WAIT) == 0) {
+        // Ages are relative to the notification timestamp, taken with its first event.
+        if (count == 0) {
+            now = k_uptime_get();
+        }
+
+        add_position_event(&events[count], &item, now);
+        if (++count == max_count) {
+            send_position_events(buf, count, now);
+            count = 0;
+        }
+    }
+
+    if (count > 0) {
+        send_position_events(buf, count, now);
+    }
+
+    // Any events queued after the bitmap was updated are sent again later, which the central
+    // ignores since they no longer change its state.
+    if (atomic_clear(&position_resync_pending)) {
+        send_position_events_full_state();
+    }
+}
+
+K_WORK_DELAYABLE_DEFINE(service_position_events_work, send_position_events_callback);
+
+static void position_events_interval_callback(struct bt_conn *conn, void *data) {
+    uint16_t *interval = data;
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) == 0) {
+        *interval = MIN(*interval, info.le.interval);
+    }
+}
+
+// How long to keep collecting key position events before notifying them. Notifications only go
+// out on the next connection event anyway, so waiting up to half a connection interval lets events
+// from the same scan share a notification while rarely missing the event it would have made.
+static k_timeout_t position_events_window(void) {
+    if (CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_EVENTS_WINDOW == 0) {
+        return K_NO_WAIT;
+    }
+
+    uint16_t interval = UINT16_MAX;
+    bt_conn_foreach(BT_CONN_TYPE_LE, position_events_interval_callback, &interval);
+    if (interval == UINT16_MAX) {
+        return K_NO_WAIT;
+    }
+
+    // Connection intervals are in units of 1.25 ms.
+    uint32_t half_interval_us = interval * 1250U / 2;
+    return K_USEC(MIN(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_EVENTS_WINDOW, half_interval_us));
+}
+
+static void position_resync_callback(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(position_resync_work, position_resync_callback);
+
+static void position_resync_callback(struct k_work *work) {
+    atomic_set(&position_resync_pending, 1);
+    k_work_reschedule_for_queue(&service_work_q, &service_position_events_work, K_NO_WAIT);
+
+#if CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_RESYNC_INTERVAL > 0
+    if (position_events_enabled) {
+        k_work_schedule_for_queue(&service_work_q, &position_resync_work,
+                                  K_MSEC(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_RESYNC_INTERVAL));
+    }
+#endif
+}
+
+static void split_svc_pos_events_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("value %d", value);
+
+    position_events_enabled = (value == BT_GATT_CCC_NOTIFY);
+    if (position_events_enabled) {
+        // Start the event stream from a known state.
+        k_work_reschedule_for_queue(&service_work_q, &position_resync_work, K_NO_WAIT);
+    } else {
+        k_work_cancel_delayable(&position_resync_work);
+    }
+}
+
+static int send_position_event(uint32_t position, bool state, int64_t timestamp) {
+    struct position_event_item item = {.timestamp = timestamp,
+                                       .queued_at = k_uptime_ticks(),
+                                       .position = position,
+                                       .state = state};
+
+    if (k_msgq_put(&position_event_msgq, &item, K_NO_WAIT) != 0) {
+        // Dropping a single event would leave the central out of sync, so replace everything
+        // queued with the full position state instead.
+        LOG_WRN("Position event queue full, sending full position state instead");
+        k_msgq_purge(&position_event_msgq);
+        atomic_set(&position_resync_pending, 1);
+        k_work_reschedule_for_queue(&service_work_q, &service_position_events_work, K_NO_WAIT);
+    } else if (k_msgq_num_used_get(&position_event_msgq) >= position_events_per_notify()) {
+        // A full notification is ready, waiting any longer would only add latency.
+        k_work_reschedule_for_queue(&service_work_q, &service_position_events_work, K_NO_WAIT);
+    } else {
+        // Doesn't move an already scheduled send, so the window starts with the first event.
+        k_work_schedule_for_queue(&service_work_q, &service_position_events_work,
+                                  position_events_window());
+    }
+
+    return 0;
 }
 
-int zmk_split_bt_position_released(uint8_t position) {
-    WRITE_BIT(position_state[position / 8], position % 8, false);
+void zmk_split_bt_peripheral_get_position_events_stats(
+    struct zmk_split_bt_peripheral_position_events_stats *stats) {
+    *stats = position_events_stats;
+}
+
+#if IS_ENABLED(CONFIG_SHELL)
+
+static int split_peripheral_cmd_stats(const struct shell *sh, size_t argc, char **argv) {
+    struct zmk_split_bt_peripheral_position_events_stats stats;
+    zmk_split_bt_peripheral_get_position_events_stats(&stats);
+
+    shell_print(sh, "%u key position events in %u notifications", stats.events,
+                stats.notifications);
+    if (stats.events > 0) {
+        shell_print(sh, "Average delay before sending: %u us",
+                    (uint32_t)(stats.total_delay_us / stats.events));
+    }
+
+    return 0;
+}
+
+static int split_peripheral_cmd_reset(const struct shell *sh, size_t argc, char **argv) {
+    position_events_stats = (struct zmk_split_bt_peripheral_position_events_stats){0};
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    split_peripheral_cmds,
+    SHELL_CMD(stats, NULL, "Print key position event statistics", split_peripheral_cmd_stats),
+    SHELL_CMD(reset, NULL, "Reset key position event statistics", split_peripheral_cmd_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(split_peripheral, &split_peripheral_cmds, "Split peripheral commands", NULL);
+
+#endif // IS_ENABLED(CONFIG_SHELL)
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
+static int send_position_change(uint32_t position, bool state, int64_t timestamp) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    if (position_events_enabled) {
+        return send_position_event(position, state, timestamp);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
     return send_position_state();
 }
 
+static int send_position(uint32_t position, bool state, int64_t timestamp) {
+    if (position >= POS_STATE_LEN * 8) {
+        return -EINVAL;
+    }
+
+    WRITE_BIT(position_state[position / 8], position % 8, state);
+    return send_position_change(position, state, timestamp);
+}
+
 #if ZMK_KEYMAP_HAS_SENSORS
 K_MSGQ_DEFINE(sensor_state_msgq, sizeof(struct sensor_event),
               CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
@@ -250,9 +662,9 @@ int send_sensor_state(struct sensor_event ev) {
     return 0;
 }
 
-int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
-                                  const struct zmk_sensor_channel_data channel_data[],
-                                  size_t channel_data_size) {
+static int send_sensor_event(uint8_t sensor_index,
+                             const struct zmk_sensor_channel_data channel_data[],
+                             size_t channel_data_size) {
     if (channel_data_size > ZMK_SENSOR_EVENT_MAX_CHANNELS) {
         return -EINVAL;
     }
@@ -265,12 +677,44 @@ int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
 }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+static int split_peripheral_bt_report_event(const struct zmk_split_transport_peripheral_event *ev) {
+    switch (ev->type) {
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT:
+        return send_position(ev->data.key_position_event.position,
+                             ev->data.key_position_event.pressed,
+                             ev->data.key_position_event.timestamp);
+#if ZMK_KEYMAP_HAS_SENSORS
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT:
+        return send_sensor_event(ev->data.sensor_event.sensor_index,
+                                 ev->data.sensor_event.channel_data,
+                                 ev->data.sensor_event.channel_data_size);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT:
+        // The central reads battery levels through the standard Battery Service.
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static const struct zmk_split_transport_peripheral_api bt_peripheral_api = {
+    .report_event = split_peripheral_bt_report_event,
+};
+
+ZMK_SPLIT_TRANSPORT_PERIPHERAL_REGISTER(bt_peripheral_transport, &bt_peripheral_api);
+
 static int service_init(void) {
     static const struct k_work_queue_config queue_config = {
         .name = "Split Peripheral Notification Queue"};
     k_work_queue_start(&service_work_q, service_q_stack, K_THREAD_STACK_SIZEOF(service_q_stack),
                        CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_PRIORITY, &queue_config);
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+    position_events_attr =
+        bt_gatt_find_by_uuid(split_svc.attrs, split_svc.attr_count,
+                             BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID));
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_POSITION_EVENTS)
+
     return 0;
 }
 
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/iterable_sections.h>
+#if IS_ENABLED(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/behavior.h>
+#include <zmk/matrix.h>
+#include <zmk/sensors.h>
+#include <zmk/split/central.h>
+#include <zmk/split/transport/central.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/sensor_event.h>
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+#include <zmk/events/battery_state_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+#define POSITION_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
+struct peripheral_state {
+    // Transport the peripheral is connected through, NULL while disconnected.
+    const struct zmk_split_transport_central *transport;
+    // Key position state last reported by the peripheral.
+    uint8_t position_state[POSITION_STATE_LEN];
+    // Key position state last raised as events, only used by the event work.
+    uint8_t raised_position_state[POSITION_STATE_LEN];
+    struct k_msgq event_msgq;
+    char __aligned(4) event_msgq_buf[CONFIG_ZMK_SPLIT_CENTRAL_POSITION_QUEUE_SIZE *
+                                     sizeof(struct zmk_position_state_changed)];
+    struct zmk_split_central_peripheral_stats stats;
+    uint8_t battery_level;
+};
+
+static struct peripheral_state peripherals[ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT];
+
+static ATOMIC_DEFINE(position_resync_pending, ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT);
+
+static void raise_position_event(uint8_t source, uint32_t position, bool pressed,
+                                 int64_t timestamp) {
+    uint8_t *raised_state = peripherals[source].raised_position_state;
+
+    // Events queued before a resync may already have been raised by it.
+    if (((raised_state[position / 8] & BIT(position % 8)) != 0) == pressed) {
+        return;
+    }
+
+    WRITE_BIT(raised_state[position / 8], position % 8, pressed);
+
+    LOG_DBG("Trigger key position state change for %d", position);
+    raise_zmk_position_state_changed((struct zmk_position_state_changed){
+        .source = source, .position = position, .state = pressed, .timestamp = timestamp});
+}
+
+static void resync_positions(uint8_t source) {
+    struct peripheral_state *peripheral = &peripherals[source];
+    int64_t now = k_uptime_get();
+
+    LOG_DBG("Resyncing key positions of peripheral %d", source);
+    peripheral->stats.resyncs++;
+
+    for (size_t i = 0; i < POSITION_STATE_LEN; i++) {
+        uint8_t changed = peripheral->position_state[i] ^ peripheral->raised_position_state[i];
+        for (int j = 0; changed && j < 8; j++) {
+            if (changed & BIT(j)) {
+                raise_position_event(source, (i * 8) + j, peripheral->position_state[i] & BIT(j),
+                                     now);
+            }
+        }
+    }
+}
+
+static void peripheral_event_work_callback(struct k_work *work) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        struct zmk_position_state_changed ev;
+        while (k_msgq_get(&peripherals[i].event_msgq, &ev, K_NO_WAIT) == 0) {
+            raise_position_event(i, ev.position, ev.state, ev.timestamp);
+        }
+
+        if (atomic_test_and_clear_bit(position_resync_pending, i)) {
+            resync_positions(i);
+        }
+    }
+}
+
+static K_WORK_DEFINE(peripheral_event_work, peripheral_event_work_callback);
+
+static void queue_position_event(uint8_t source, uint32_t position, bool pressed,
+                                 int64_t timestamp) {
+    struct peripheral_state *peripheral = &peripherals[source];
+    struct zmk_position_state_changed ev = {
+        .source = source, .position = position, .state = pressed, .timestamp = timestamp};
+
+    if (k_msgq_put(&peripheral->event_msgq, &ev, K_NO_WAIT) == 0) {
+        struct zmk_split_central_peripheral_stats *stats = &peripheral->stats;
+        stats->queue_high_water_mark =
+            MAX(stats->queue_high_water_mark, k_msgq_num_used_get(&peripheral->event_msgq));
+    } else {
+        // The position state already holds the change, so raise whatever differs from it instead
+        // of losing the event and leaving a key stuck.
+        LOG_WRN("Event queue of peripheral %d full, resyncing its key positions", source);
+        peripheral->stats.dropped_events++;
+        atomic_set_bit(position_resync_pending, source);
+    }
+
+    k_work_submit(&peripheral_event_work);
+}
+
+static int set_position_state(uint8_t source, uint32_t position, bool pressed, int64_t timestamp) {
+    struct peripheral_state *peripheral = &peripherals[source];
+
+    if (position >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Ignoring event for out of range position %d", position);
+        return -EINVAL;
+    }
+
+    if (((peripheral->position_state[position / 8] & BIT(position % 8)) != 0) == pressed) {
+        return 0;
+    }
+
+    WRITE_BIT(peripheral->position_state[position / 8], position % 8, pressed);
+    queue_position_event(source, position, pressed, timestamp);
+
+    return 0;
+}
+
+static void release_all_positions(uint8_t source) {
+    struct peripheral_state *peripheral = &peripherals[source];
+
+    for (size_t i = 0; i < POSITION_STATE_LEN; i++) {
+        for (int j = 0; peripheral->position_state[i] && j < 8; j++) {
+            if (peripheral->position_state[i] & BIT(j)) {
+                set_position_state(source, (i * 8) + j, false, k_uptime_get());
+            }
+        }
+    }
+}
+
+#if ZMK_KEYMAP_HAS_SENSORS
+
+K_MSGQ_DEFINE(peripheral_sensor_event_msgq, sizeof(struct zmk_sensor_event),
+              CONFIG_ZMK_SPLIT_CENTRAL_POSITION_QUEUE_SIZE, 4);
+
+static void peripheral_sensor_event_work_callback(struct k_work *work) {
+    struct zmk_sensor_event ev;
+    while (k_msgq_get(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT) == 0) {
+        LOG_DBG("Trigger sensor change for %d", ev.sensor_index);
+        raise_zmk_sensor_event(ev);
+    }
+}
+
+static K_WORK_DEFINE(peripheral_sensor_event_work, peripheral_sensor_event_work_callback);
+
+static int handle_sensor_event(const struct zmk_split_transport_peripheral_event *ev) {
+    struct zmk_sensor_event sensor_ev = {
+        .sensor_index = ev->data.sensor_event.sensor_index,
+        .channel_data_size =
+            MIN(ev->data.sensor_event.channel_data_size, ZMK_SENSOR_EVENT_MAX_CHANNELS),
+        .timestamp = k_uptime_get()};
+
+    memcpy(sensor_ev.channel_data, ev->data.sensor_event.channel_data,
+           sizeof(struct zmk_sensor_channel_data) * sensor_ev.channel_data_size);
+    k_msgq_put(&peripheral_sensor_event_msgq, &sensor_ev, K_NO_WAIT);
+    k_work_submit(&peripheral_sensor_event_work);
+
+    return 0;
+}
+
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+K_MSGQ_DEFINE(peripheral_batt_lvl_msgq, sizeof(struct zmk_peripheral_battery_state_changed),
+              CONFIG_ZMK_SPLIT_CENTRAL_BATTERY_LEVEL_QUEUE_SIZE, 4);
+
+static void peripheral_batt_lvl_change_callback(struct k_work *work) {
+    struct zmk_peripheral_battery_state_changed ev;
+    while (k_msgq_get(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT) == 0) {
+        LOG_DBG("Triggering peripheral battery level change %u", ev.state_of_charge);
+        raise_zmk_peripheral_battery_state_changed(ev);
+    }
+}
+
+static K_WORK_DEFINE(peripheral_batt_lvl_work, peripheral_batt_lvl_change_callback);
+
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+static void set_battery_level(uint8_t source, uint8_t level) {
+    peripherals[source].battery_level = level;
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+    struct zmk_peripheral_battery_state_changed ev = {.source = source, .state_of_charge = level};
+    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
+    k_work_submit(&peripheral_batt_lvl_work);
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+}
+
+int zmk_split_transport_central_peripheral_event_handler(
+    const struct zmk_split_transport_central *transport, uint8_t source,
+    struct zmk_split_transport_peripheral_event ev) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    if (peripherals[source].transport != transport) {
+        LOG_WRN("Ignoring event from peripheral %d, not connected through this transport", source);
+        return -ENOTCONN;
+    }
+
+    switch (ev.type) {
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT:
+        return set_position_state(source, ev.data.key_position_event.position,
+                                  ev.data.key_position_event.pressed,
+                                  ev.data.key_position_event.timestamp);
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT:
+#if ZMK_KEYMAP_HAS_SENSORS
+        return handle_sensor_event(&ev);
+#else
+        return -ENOTSUP;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT:
+        set_battery_level(source, ev.data.battery_event.level);
+        return 0;
+    }
+
+    return -ENOTSUP;
+}
+
+int zmk_split_transport_central_peripheral_status_changed(
+    const struct zmk_split_transport_central *transport, uint8_t source, bool connected) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    struct peripheral_state *peripheral = &peripherals[source];
+
+    if (connected) {
+        peripheral->transport = transport;
+        return 0;
+    }
+
+    if (peripheral->transport != transport) {
+        return -ENOTCONN;
+    }
+
+    LOG_DBG("Peripheral %d disconnected, releasing its key positions", source);
+
+    release_all_positions(source);
+    peripheral->transport = NULL;
+
+    if (peripheral->battery_level > 0) {
+        set_battery_level(source, 0);
+    }
+
+    return 0;
+}
+
+static int send_command(uint8_t source, struct zmk_split_transport_central_command cmd) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    const struct zmk_split_transport_central *transport = peripherals[source].transport;
+    if (!transport) {
+        return -ENOTCONN;
+    }
+
+    return transport->api->send_command(source, cmd);
+}
+
+int zmk_split_central_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                                      struct zmk_behavior_binding_event event, bool state) {
+    struct zmk_split_transport_central_command cmd = {
+        .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
+        .data.invoke_behavior =
+            {
+                .behavior_dev = binding->behavior_dev,
+                .param1 = binding->param1,
+                .param2 = binding->param2,
+                .position = event.position,
+                .state = state,
+            },
+    };
+
+    return send_command(source, cmd);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_central_update_hid_indicator(zmk_hid_indicators_t indicators) {
+    struct zmk_split_transport_central_command cmd = {
+        .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS,
+        .data.set_hid_indicators = {.indicators = indicators},
+    };
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        int err = send_command(i, cmd);
+        if (err < 0 && err != -ENOTCONN) {
+            LOG_ERR("Failed to send HID indicators to peripheral %d (err %d)", i, err);
+        }
+    }
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_central_get_peripheral_stats(uint8_t source,
+                                           struct zmk_split_central_peripheral_stats *stats) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    *stats = peripherals[source].stats;
+    return 0;
+}
+
+int zmk_split_get_peripheral_battery_level(uint8_t source, uint8_t *level) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    if (!peripherals[source].transport) {
+        return -ENOTCONN;
+    }
+
+    *level = peripherals[source].battery_level;
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_SHELL)
+
+static int split_central_cmd_stats(const struct shell *sh, size_t argc, char **argv) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        struct zmk_split_central_peripheral_stats stats;
+        zmk_split_central_get_peripheral_stats(i, &stats);
+
+        shell_print(sh, "Peripheral %u: at most %u of %u events queued", i,
+                    stats.queue_high_water_mark, CONFIG_ZMK_SPLIT_CENTRAL_POSITION_QUEUE_SIZE);
+        shell_print(sh, "Peripheral %u: %u dropped events, %u resyncs", i, stats.dropped_events,
+                    stats.resyncs);
+    }
+
+    return 0;
+}
+
+static int split_central_cmd_reset(const struct shell *sh, size_t argc, char **argv) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        peripherals[i].stats = (struct zmk_split_central_peripheral_stats){0};
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    split_central_cmds,
+    SHELL_CMD(stats, NULL, "Print peripheral key position queue statistics",
+              split_central_cmd_stats),
+    SHELL_CMD(reset, NULL, "Reset peripheral key position queue statistics",
+              split_central_cmd_reset),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(split_central, &split_central_cmds, "Split central commands", NULL);
+
+#endif // IS_ENABLED(CONFIG_SHELL)
+
+static int zmk_split_central_init(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
+        k_msgq_init(&peripherals[i].event_msgq, peripherals[i].event_msgq_buf,
+                    sizeof(struct zmk_position_state_changed),
+                    CONFIG_ZMK_SPLIT_CENTRAL_POSITION_QUEUE_SIZE);
+    }
+
+    return 0;
+}
+
+SYS_INIT(zmk_split_central_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_split_loopback
+
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/kscan.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <drivers/behavior.h>
+#include <zmk/behavior.h>
+#include <zmk/matrix_transform.h>
+#include <zmk/split/transport/central.h>
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1,
+             "Loopback split requires exactly one zmk,split-loopback node");
+
+#define PERIPHERAL_SOURCE 0
+
+static const struct device *kscan = DEVICE_DT_GET(DT_INST_PHANDLE(0, kscan));
+
+#if DT_INST_NODE_HAS_PROP(0, matrix_transform)
+
+ZMK_MATRIX_TRANSFORM_EXTERN(DT_INST_PHANDLE(0, matrix_transform));
+static const zmk_matrix_transform_t transform =
+    ZMK_MATRIX_TRANSFORM_T_FOR_NODE(DT_INST_PHANDLE(0, matrix_transform));
+
+#else
+
+BUILD_ASSERT(!DT_HAS_COMPAT_STATUS_OKAY(zmk_matrix_transform),
+             "Loopback split needs a matrix-transform when matrix transforms are defined");
+
+ZMK_MATRIX_TRANSFORM_DEFAULT_EXTERN();
+static const zmk_matrix_transform_t transform = &zmk_matrix_transform_default;
+
+#endif // DT_INST_NODE_HAS_PROP(0, matrix_transform)
+
+static const struct zmk_split_transport_central loopback_central_transport;
+
+struct loopback_kscan_event {
+    uint32_t row;
+    uint32_t column;
+    bool pressed;
+    int64_t timestamp;
+};
+
+K_MSGQ_DEFINE(loopback_kscan_msgq, sizeof(struct loopback_kscan_event),
+              CONFIG_ZMK_SPLIT_CENTRAL_POSITION_QUEUE_SIZE, 4);
+
+static void loopback_kscan_work_callback(struct k_work *work) {
+    struct loopback_kscan_event kscan_ev;
+
+    while (k_msgq_get(&loopback_kscan_msgq, &kscan_ev, K_NO_WAIT) == 0) {
+        int32_t position =
+            zmk_matrix_transform_row_column_to_position(transform, kscan_ev.row, kscan_ev.column);
+
+        if (position < 0) {
+            LOG_WRN("Not found in transform: row: %d, col: %d", kscan_ev.row, kscan_ev.column);
+            continue;
+        }
+
+        LOG_DBG("Loopback peripheral position %d, pressed: %d", position, kscan_ev.pressed);
+
+        struct zmk_split_transport_peripheral_event ev = {
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+            .data.key_position_event =
+                {
+                    .position = position,
+                    .pressed = kscan_ev.pressed,
+                    .timestamp = kscan_ev.timestamp,
+                },
+        };
+
+        zmk_split_transport_central_peripheral_event_handler(&loopback_central_transport,
+                                                             PERIPHERAL_SOURCE, ev);
+    }
+}
+
+static K_WORK_DEFINE(loopback_kscan_work, loopback_kscan_work_callback);
+
+static void loopback_kscan_callback(const struct device *dev, uint32_t row, uint32_t column,
+                                    bool pressed) {
+    struct loopback_kscan_event ev = {
+        .row = row, .column = column, .pressed = pressed, .timestamp = k_uptime_get()};
+
+    k_msgq_put(&loopback_kscan_msgq, &ev, K_NO_WAIT);
+    k_work_submit(&loopback_kscan_work);
+}
+
+static int loopback_invoke_behavior(const struct zmk_split_transport_central_command *cmd) {
+    struct zmk_behavior_binding binding = {
+        .param1 = cmd->data.invoke_behavior.param1,
+        .param2 = cmd->data.invoke_behavior.param2,
+        .behavior_dev = cmd->data.invoke_behavior.behavior_dev,
+    };
+    struct zmk_behavior_binding_event event = {.position = cmd->data.invoke_behavior.position,
+                                               .timestamp = k_uptime_get()};
+
+    LOG_DBG("Loopback peripheral %s with params %d %d: pressed? %d", binding.behavior_dev,
+            binding.param1, binding.param2, cmd->data.invoke_behavior.state);
+
+    if (cmd->data.invoke_behavior.state) {
+        return behavior_keymap_binding_pressed(&binding, event);
+    } else {
+        return behavior_keymap_binding_released(&binding, event);
+    }
+}
+
+static int loopback_send_command(uint8_t source, struct zmk_split_transport_central_command cmd) {
+    if (source != PERIPHERAL_SOURCE) {
+        return -EINVAL;
+    }
+
+    switch (cmd.type) {
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR:
+        return loopback_invoke_behavior(&cmd);
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS:
+        // The central already raises its own indicators event, doing it again here would only
+        // duplicate it.
+        LOG_DBG("Loopback peripheral HID indicators: %x", cmd.data.set_hid_indicators.indicators);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static const struct zmk_split_transport_central_api loopback_central_api = {
+    .send_command = loopback_send_command,
+};
+
+ZMK_SPLIT_TRANSPORT_CENTRAL_REGISTER(loopback_central_transport, &loopback_central_api);
+
+static int zmk_split_loopback_init(void) {
+    if (!device_is_ready(kscan)) {
+        LOG_ERR("Loopback split kscan device is not ready");
+        return -ENODEV;
+    }
+
+    zmk_split_transport_central_peripheral_status_changed(&loopback_central_transport,
+                                                          PERIPHERAL_SOURCE, true);
+
+    kscan_config(kscan, loopback_kscan_callback);
+    kscan_enable_callback(kscan);
+
+    return 0;
+}
+
+SYS_INIT(zmk_split_loopback_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/iterable_sections.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <drivers/behavior.h>
+#include <zmk/behavior.h>
+#include <zmk/sensors.h>
+#include <zmk/split/transport/peripheral.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/sensor_event.h>
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+#include <zmk/events/battery_state_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#include <zmk/events/hid_indicators_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+static int report_event(const struct zmk_split_transport_peripheral_event *ev) {
+    int ret = -ENODEV;
+
+    STRUCT_SECTION_FOREACH(zmk_split_transport_peripheral, transport) {
+        ret = transport->api->report_event(ev);
+        if (ret < 0) {
+            LOG_WRN("Failed to report split event %d (err %d)", ev->type, ret);
+        }
+    }
+
+    return ret;
+}
+
+static int split_peripheral_listener(const zmk_event_t *eh) {
+    LOG_DBG("");
+    const struct zmk_position_state_changed *pos_ev = as_zmk_position_state_changed(eh);
+    if (pos_ev != NULL) {
+        struct zmk_split_transport_peripheral_event ev = {
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+            .data.key_position_event = {.position = pos_ev->position,
+                                        .pressed = pos_ev->state,
+                                        .timestamp = pos_ev->timestamp},
+        };
+
+        report_event(&ev);
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+#if ZMK_KEYMAP_HAS_SENSORS
+    const struct zmk_sensor_event *sensor_ev = as_zmk_sensor_event(eh);
+    if (sensor_ev != NULL) {
+        struct zmk_split_transport_peripheral_event ev = {
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT,
+            .data.sensor_event = {.sensor_index = sensor_ev->sensor_index,
+                                  .channel_data_size = MIN(sensor_ev->channel_data_size,
+                                                           ZMK_SENSOR_EVENT_MAX_CHANNELS)},
+        };
+
+        memcpy(ev.data.sensor_event.channel_data, sensor_ev->channel_data,
+               sizeof(struct zmk_sensor_channel_data) * ev.data.sensor_event.channel_data_size);
+        report_event(&ev);
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+    const struct zmk_battery_state_changed *batt_ev = as_zmk_battery_state_changed(eh);
+    if (batt_ev != NULL) {
+        struct zmk_split_transport_peripheral_event ev = {
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT,
+            .data.battery_event = {.level = batt_ev->state_of_charge},
+        };
+
+        report_event(&ev);
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_peripheral_listener, split_peripheral_listener);
+ZMK_SUBSCRIPTION(split_peripheral_listener, zmk_position_state_changed);
+
+#if ZMK_KEYMAP_HAS_SENSORS
+ZMK_SUBSCRIPTION(split_peripheral_listener, zmk_sensor_event);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+ZMK_SUBSCRIPTION(split_peripheral_listener, zmk_battery_state_changed);
+#endif // IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+
+static int invoke_behavior(const struct zmk_split_transport_central_command *cmd) {
+    struct zmk_behavior_binding binding = {
+        .param1 = cmd->data.invoke_behavior.param1,
+        .param2 = cmd->data.invoke_behavior.param2,
+        .behavior_dev = cmd->data.invoke_behavior.behavior_dev,
+    };
+    struct zmk_behavior_binding_event event = {.position = cmd->data.invoke_behavior.position,
+                                               .timestamp = k_uptime_get()};
+
+    LOG_DBG("%s with params %d %d: pressed? %d", binding.behavior_dev, binding.param1,
+            binding.param2, cmd->data.invoke_behavior.state);
+
+    int err;
+    if (cmd->data.invoke_behavior.state) {
+        err = behavior_keymap_binding_pressed(&binding, event);
+    } else {
+        err = behavior_keymap_binding_released(&binding, event);
+    }
+
+    if (err) {
+        LOG_ERR("Failed to invoke behavior %s: %d", binding.behavior_dev, err);
+    }
+
+    return err;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+static zmk_hid_indicators_t hid_indicators = 0;
+
+static void update_indicators_callback(struct k_work *work) {
+    LOG_DBG("Raising HID indicators changed event: %x", hid_indicators);
+    raise_zmk_hid_indicators_changed(
+        (struct zmk_hid_indicators_changed){.indicators = hid_indicators});
+}
+
+static K_WORK_DEFINE(update_indicators_work, update_indicators_callback);
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_transport_peripheral_command_handler(
+    const struct zmk_split_transport_peripheral *transport,
+    struct zmk_split_transport_central_command cmd) {
+    switch (cmd.type) {
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR:
+        return invoke_behavior(&cmd);
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS:
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+        hid_indicators = cmd.data.set_hid_indicators.indicators;
+        k_work_submit(&update_indicators_work);
+        return 0;
+#else
+        return -ENOTSUP;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    }
+
+    return -ENOTSUP;
+}
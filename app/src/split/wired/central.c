@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/stdlib.h>
+#include <zmk/sensors.h>
+#include <zmk/split/transport/central.h>
+
+#include "wired.h"
+
+#define PERIPHERAL_SOURCE 0
+
+#define PERIPHERAL_TIMEOUT K_MSEC(CONFIG_ZMK_SPLIT_WIRED_PERIPHERAL_TIMEOUT)
+
+static uint8_t position_state[ZMK_SPLIT_WIRED_POS_STATE_LEN];
+static bool peripheral_connected;
+// Set once the full position state was requested, until the peripheral sends anything.
+static bool position_state_requested;
+
+static const struct zmk_split_transport_central wired_central_transport;
+
+static void report_event(struct zmk_split_transport_peripheral_event ev) {
+    zmk_split_transport_central_peripheral_event_handler(&wired_central_transport,
+                                                         PERIPHERAL_SOURCE, ev);
+}
+
+static void set_position_state(uint32_t position, bool pressed) {
+    if (position >= ZMK_SPLIT_WIRED_POS_STATE_LEN * 8) {
+        LOG_WRN("Ignoring event for out of range position %d", position);
+        return;
+    }
+
+    if (((position_state[position / 8] & BIT(position % 8)) != 0) == pressed) {
+        return;
+    }
+
+    WRITE_BIT(position_state[position / 8], position % 8, pressed);
+
+    report_event((struct zmk_split_transport_peripheral_event){
+        .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+        .data.key_position_event =
+            {
+                .position = position,
+                .pressed = pressed,
+                .timestamp = k_uptime_get(),
+            },
+    });
+}
+
+static void apply_position_state(const uint8_t *state, size_t len) {
+    for (size_t i = 0; i < ZMK_SPLIT_WIRED_POS_STATE_LEN; i++) {
+        uint8_t byte = i < len ? state[i] : 0;
+        uint8_t changed = byte ^ position_state[i];
+
+        for (int j = 0; changed && j < 8; j++) {
+            if (changed & BIT(j)) {
+                set_position_state((i * 8) + j, byte & BIT(j));
+            }
+        }
+    }
+}
+
+static bool any_position_pressed(void) {
+    for (size_t i = 0; i < ZMK_SPLIT_WIRED_POS_STATE_LEN; i++) {
+        if (position_state[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void request_position_state(void) {
+    struct zmk_split_wired_msg msg = {.type = ZMK_SPLIT_WIRED_MSG_POSITION_STATE_REQUEST};
+
+    position_state_requested = true;
+    zmk_split_wired_send(&msg, 0);
+}
+
+static void request_position_state_callback(struct k_work *work) { request_position_state(); }
+
+static K_WORK_DEFINE(request_position_state_work, request_position_state_callback);
+
+static void peripheral_timeout_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(peripheral_timeout_work, peripheral_timeout_callback);
+
+// A silent peripheral only matters while some of its keys are held, since a release may have been
+// lost. The link stays quiet otherwise.
+static void update_peripheral_timeout(void) {
+    if (any_position_pressed()) {
+        k_work_reschedule_for_queue(&zmk_split_wired_work_q, &peripheral_timeout_work,
+                                    PERIPHERAL_TIMEOUT);
+    } else {
+        k_work_cancel_delayable(&peripheral_timeout_work);
+    }
+}
+
+static void peripheral_timeout_callback(struct k_work *work) {
+    if (!position_state_requested) {
+        LOG_DBG("No messages from the peripheral, requesting its key position state");
+        request_position_state();
+        k_work_reschedule_for_queue(&zmk_split_wired_work_q, &peripheral_timeout_work,
+                                    PERIPHERAL_TIMEOUT);
+        return;
+    }
+
+    LOG_WRN("No response from the peripheral, releasing its key positions");
+
+    peripheral_connected = false;
+    memset(position_state, 0, sizeof(position_state));
+    zmk_split_transport_central_peripheral_status_changed(&wired_central_transport,
+                                                          PERIPHERAL_SOURCE, false);
+}
+
+#if ZMK_KEYMAP_HAS_SENSORS
+
+static void handle_sensor_event(const struct zmk_split_wired_sensor_event *sensor_event,
+                                size_t len) {
+    if (len < offsetof(struct zmk_split_wired_sensor_event, channel_data)) {
+        LOG_WRN("Ignoring sensor event with insufficient data length (%zu)", len);
+        return;
+    }
+
+    struct zmk_split_transport_peripheral_event ev = {
+        .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT,
+        .data.sensor_event =
+            {
+                .sensor_index = sensor_event->sensor_index,
+                .channel_data_size =
+                    MIN(sensor_event->channel_data_size, ZMK_SENSOR_EVENT_MAX_CHANNELS),
+            },
+    };
+
+    memcpy(ev.data.sensor_event.channel_data, sensor_event->channel_data,
+           sizeof(struct zmk_sensor_channel_data) * ev.data.sensor_event.channel_data_size);
+    report_event(ev);
+}
+
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+void zmk_split_wired_msg_received(const struct zmk_split_wired_msg *msg, size_t body_len) {
+    if (!peripheral_connected) {
+        peripheral_connected = true;
+        zmk_split_transport_central_peripheral_status_changed(&wired_central_transport,
+                                                              PERIPHERAL_SOURCE, true);
+    }
+
+    position_state_requested = false;
+
+    switch (msg->type) {
+    case ZMK_SPLIT_WIRED_MSG_POSITION_EVENT:
+        if (body_len < sizeof(msg->body.position_event)) {
+            break;
+        }
+
+        set_position_state(sys_le16_to_cpu(msg->body.position_event.position),
+                           msg->body.position_event.state);
+        break;
+    case ZMK_SPLIT_WIRED_MSG_POSITION_STATE:
+        apply_position_state(msg->body.position_state, body_len);
+        break;
+#if ZMK_KEYMAP_HAS_SENSORS
+    case ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT:
+        handle_sensor_event(&msg->body.sensor_event, body_len);
+        break;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+    case ZMK_SPLIT_WIRED_MSG_BATTERY_LEVEL:
+        if (body_len < sizeof(msg->body.battery_level)) {
+            break;
+        }
+
+        report_event((struct zmk_split_transport_peripheral_event){
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT,
+            .data.battery_event = {.level = msg->body.battery_level},
+        });
+        break;
+    default:
+        LOG_WRN("Ignoring unexpected wired split message type %d", msg->type);
+        break;
+    }
+
+    update_peripheral_timeout();
+}
+
+static int invoke_behavior(const struct zmk_split_transport_central_command *cmd) {
+    struct zmk_split_wired_msg msg = {
+        .type = ZMK_SPLIT_WIRED_MSG_RUN_BEHAVIOR,
+        .body.run_behavior =
+            {
+                .position = sys_cpu_to_le16(cmd->data.invoke_behavior.position),
+                .state = cmd->data.invoke_behavior.state ? 1 : 0,
+                .param1 = sys_cpu_to_le32(cmd->data.invoke_behavior.param1),
+                .param2 = sys_cpu_to_le32(cmd->data.invoke_behavior.param2),
+            },
+    };
+
+    const size_t behavior_dev_size = sizeof(msg.body.run_behavior.behavior_dev);
+    size_t behavior_dev_len = strlcpy(msg.body.run_behavior.behavior_dev,
+                                      cmd->data.invoke_behavior.behavior_dev, behavior_dev_size);
+    if (behavior_dev_len >= behavior_dev_size) {
+        LOG_ERR("Behavior label %s is too long to invoke on the peripheral",
+                cmd->data.invoke_behavior.behavior_dev);
+        return -EINVAL;
+    }
+
+    // The message ends with the terminator of the label.
+    return zmk_split_wired_send(
+        &msg, offsetof(struct zmk_split_wired_run_behavior, behavior_dev) + behavior_dev_len + 1);
+}
+
+static int wired_central_send_command(uint8_t source,
+                                      struct zmk_split_transport_central_command cmd) {
+    if (source != PERIPHERAL_SOURCE) {
+        return -EINVAL;
+    }
+
+    if (!peripheral_connected) {
+        return -ENOTCONN;
+    }
+
+    switch (cmd.type) {
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR:
+        return invoke_behavior(&cmd);
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS: {
+        struct zmk_split_wired_msg msg = {
+            .type = ZMK_SPLIT_WIRED_MSG_HID_INDICATORS,
+            .body.hid_indicators = cmd.data.set_hid_indicators.indicators,
+        };
+
+        return zmk_split_wired_send(&msg, sizeof(msg.body.hid_indicators));
+    }
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static const struct zmk_split_transport_central_api wired_central_api = {
+    .send_command = wired_central_send_command,
+};
+
+ZMK_SPLIT_TRANSPORT_CENTRAL_REGISTER(wired_central_transport, &wired_central_api);
+
+void zmk_split_wired_msg_lost(void) {
+    if (!position_state_requested) {
+        k_work_submit(&request_position_state_work);
+    }
+}
+
+static int wired_split_central_init(void) {
+    // The peripheral may have started first, so ask for the keys it already has pressed.
+    k_work_submit(&request_position_state_work);
+
+    return 0;
+}
+
+SYS_INIT(wired_split_central_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/stdlib.h>
+#include <zmk/sensors.h>
+#include <zmk/split/transport/peripheral.h>
+
+#include "wired.h"
+
+static uint8_t position_state[ZMK_SPLIT_WIRED_POS_STATE_LEN];
+
+// The full state is only sent when the halves may have got out of sync: at startup, when the
+// central asks for it, and after a message to or from the central was dropped.
+static void send_position_state_callback(struct k_work *work) {
+    struct zmk_split_wired_msg msg = {.type = ZMK_SPLIT_WIRED_MSG_POSITION_STATE};
+
+    memcpy(msg.body.position_state, position_state, sizeof(position_state));
+    zmk_split_wired_send(&msg, sizeof(position_state));
+}
+
+static K_WORK_DEFINE(position_state_work, send_position_state_callback);
+
+static int send_position_event(uint32_t position, bool pressed) {
+    if (position >= ZMK_SPLIT_WIRED_POS_STATE_LEN * 8) {
+        return -EINVAL;
+    }
+
+    WRITE_BIT(position_state[position / 8], position % 8, pressed);
+
+    struct zmk_split_wired_msg msg = {
+        .type = ZMK_SPLIT_WIRED_MSG_POSITION_EVENT,
+        .body.position_event = {.position = sys_cpu_to_le16(position), .state = pressed},
+    };
+
+    return zmk_split_wired_send(&msg, sizeof(msg.body.position_event));
+}
+
+#if ZMK_KEYMAP_HAS_SENSORS
+
+static int send_sensor_event(const struct zmk_split_transport_peripheral_event *ev) {
+    uint8_t channel_data_size = ev->data.sensor_event.channel_data_size;
+
+    if (channel_data_size > ZMK_SENSOR_EVENT_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    struct zmk_split_wired_msg msg = {
+        .type = ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT,
+        .body.sensor_event = {.sensor_index = ev->data.sensor_event.sensor_index,
+                              .channel_data_size = channel_data_size},
+    };
+
+    memcpy(msg.body.sensor_event.channel_data, ev->data.sensor_event.channel_data,
+           channel_data_size * sizeof(struct zmk_sensor_channel_data));
+
+    return zmk_split_wired_send(&msg, offsetof(struct zmk_split_wired_sensor_event, channel_data) +
+                                          channel_data_size *
+                                              sizeof(struct zmk_sensor_channel_data));
+}
+
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+static int wired_peripheral_report_event(const struct zmk_split_transport_peripheral_event *ev) {
+    switch (ev->type) {
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT:
+        return send_position_event(ev->data.key_position_event.position,
+                                   ev->data.key_position_event.pressed);
+#if ZMK_KEYMAP_HAS_SENSORS
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT:
+        return send_sensor_event(ev);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT: {
+        struct zmk_split_wired_msg msg = {
+            .type = ZMK_SPLIT_WIRED_MSG_BATTERY_LEVEL,
+            .body.battery_level = ev->data.battery_event.level,
+        };
+
+        return zmk_split_wired_send(&msg, sizeof(msg.body.battery_level));
+    }
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static const struct zmk_split_transport_peripheral_api wired_peripheral_api = {
+    .report_event = wired_peripheral_report_event,
+};
+
+ZMK_SPLIT_TRANSPORT_PERIPHERAL_REGISTER(wired_peripheral_transport, &wired_peripheral_api);
+
+void zmk_split_wired_msg_received(const struct zmk_split_wired_msg *msg, size_t body_len) {
+    switch (msg->type) {
+    case ZMK_SPLIT_WIRED_MSG_RUN_BEHAVIOR: {
+        const size_t behavior_dev_offset =
+            offsetof(struct zmk_split_wired_run_behavior, behavior_dev);
+        const struct zmk_split_wired_run_behavior *payload = &msg->body.run_behavior;
+
+        // The label comes straight off the wire, so it must be terminated within the message.
+        if (body_len <= behavior_dev_offset ||
+            !memchr(payload->behavior_dev, '\0', body_len - behavior_dev_offset)) {
+            LOG_WRN("Ignoring run behavior message without a terminated behavior label");
+            break;
+        }
+
+        struct zmk_split_transport_central_command cmd = {
+            .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
+            .data.invoke_behavior =
+                {
+                    .behavior_dev = payload->behavior_dev,
+                    .param1 = sys_le32_to_cpu(payload->param1),
+                    .param2 = sys_le32_to_cpu(payload->param2),
+                    .position = sys_le16_to_cpu(payload->position),
+                    .state = payload->state > 0,
+                },
+        };
+
+        zmk_split_transport_peripheral_command_handler(&wired_peripheral_transport, cmd);
+        break;
+    }
+    case ZMK_SPLIT_WIRED_MSG_HID_INDICATORS: {
+        if (body_len < sizeof(msg->body.hid_indicators)) {
+            break;
+        }
+
+        struct zmk_split_transport_central_command cmd = {
+            .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS,
+            .data.set_hid_indicators = {.indicators = msg->body.hid_indicators},
+        };
+
+        zmk_split_transport_peripheral_command_handler(&wired_peripheral_transport, cmd);
+        break;
+    }
+    case ZMK_SPLIT_WIRED_MSG_POSITION_STATE_REQUEST:
+        k_work_submit(&position_state_work);
+        break;
+    default:
+        LOG_WRN("Ignoring unexpected wired split message type %d", msg->type);
+        break;
+    }
+}
+
+void zmk_split_wired_msg_lost(void) { k_work_submit(&position_state_work); }
+
+static int wired_split_peripheral_init(void) {
+    k_work_submit(&position_state_work);
+
+    return 0;
+}
+
+SYS_INIT(wired_split_peripheral_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_wired_split
+
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/cobs.h>
+
+#include "wired.h"
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1,
+             "Wired split requires exactly one zmk,wired-split node");
+
+static const struct device *uart = DEVICE_DT_GET(DT_INST_PHANDLE(0, device));
+
+#define MSG_MAX_LEN sizeof(struct zmk_split_wired_msg)
+#define FRAME_MAX_LEN ZMK_COBS_FRAME_MAX_LEN(MSG_MAX_LEN)
+
+K_THREAD_STACK_DEFINE(wired_q_stack, CONFIG_ZMK_SPLIT_WIRED_STACK_SIZE);
+
+struct k_work_q zmk_split_wired_work_q;
+
+struct tx_item {
+    uint16_t len;
+    struct zmk_split_wired_msg msg;
+};
+
+K_MSGQ_DEFINE(wired_tx_msgq, sizeof(struct tx_item), CONFIG_ZMK_SPLIT_WIRED_TX_QUEUE_SIZE, 4);
+
+static size_t encode_frame(const struct tx_item *item, uint8_t *frame) {
+    return zmk_cobs_frame_encode((const uint8_t *)&item->msg, item->len, frame);
+}
+
+static void handle_frame(uint8_t *frame, size_t len) {
+    int msg_len = zmk_cobs_frame_decode(frame, len);
+    if (msg_len == -EBADMSG) {
+        LOG_WRN("Dropping wired split frame with invalid CRC");
+        zmk_split_wired_msg_lost();
+        return;
+    }
+
+    if (msg_len < 1 || msg_len > (int)MSG_MAX_LEN) {
+        LOG_WRN("Dropping malformed wired split frame");
+        zmk_split_wired_msg_lost();
+        return;
+    }
+
+    struct zmk_split_wired_msg msg;
+    memcpy(&msg, frame, msg_len);
+    zmk_split_wired_msg_received(&msg, msg_len - 1);
+}
+
+static uint8_t rx_frame[FRAME_MAX_LEN];
+static size_t rx_frame_len;
+static bool rx_frame_overflow;
+
+static void process_rx_bytes(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0) {
+            if (rx_frame_len < sizeof(rx_frame)) {
+                rx_frame[rx_frame_len++] = data[i];
+            } else {
+                rx_frame_overflow = true;
+            }
+            continue;
+        }
+
+        if (rx_frame_overflow) {
+            LOG_WRN("Dropping oversized wired split frame");
+            zmk_split_wired_msg_lost();
+        } else if (rx_frame_len > 0) {
+            handle_frame(rx_frame, rx_frame_len);
+        }
+
+        rx_frame_len = 0;
+        rx_frame_overflow = false;
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_ASYNC)
+
+// Received data is handed from the UART callback to the work queue through a ring buffer.
+RING_BUF_DECLARE(wired_rx_ring, FRAME_MAX_LEN * 2);
+
+static uint8_t rx_bufs[2][CONFIG_ZMK_SPLIT_WIRED_ASYNC_RX_BUF_SIZE];
+static uint8_t rx_buf_idx;
+
+static uint8_t tx_frame[FRAME_MAX_LEN];
+static K_SEM_DEFINE(tx_sem, 1, 1);
+
+static void rx_work_callback(struct k_work *work) {
+    uint8_t *data;
+    uint32_t len;
+
+    while ((len = ring_buf_get_claim(&wired_rx_ring, &data, FRAME_MAX_LEN)) > 0) {
+        process_rx_bytes(data, len);
+        ring_buf_get_finish(&wired_rx_ring, len);
+    }
+}
+
+static K_WORK_DEFINE(rx_work, rx_work_callback);
+
+static int start_rx(void) {
+    int err = uart_rx_enable(uart, rx_bufs[rx_buf_idx], sizeof(rx_bufs[rx_buf_idx]),
+                             CONFIG_ZMK_SPLIT_WIRED_ASYNC_RX_TIMEOUT_US);
+    rx_buf_idx = !rx_buf_idx;
+
+    return err;
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data) {
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        k_sem_give(&tx_sem);
+        break;
+    case UART_RX_RDY:
+        if (ring_buf_put(&wired_rx_ring, evt->data.rx.buf + evt->data.rx.offset,
+                         evt->data.rx.len) < evt->data.rx.len) {
+            LOG_WRN("Wired split receive buffer full, dropping data");
+        }
+        k_work_submit_to_queue(&zmk_split_wired_work_q, &rx_work);
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, rx_bufs[rx_buf_idx], sizeof(rx_bufs[rx_buf_idx]));
+        rx_buf_idx = !rx_buf_idx;
+        break;
+    case UART_RX_STOPPED:
+        LOG_WRN("Wired split receive stopped (reason %d)", evt->data.rx_stop.reason);
+        break;
+    case UART_RX_DISABLED: {
+        int err = start_rx();
+        if (err < 0) {
+            LOG_ERR("Failed to restart wired split receive (err %d)", err);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void send_frame(const struct tx_item *item) {
+    // The frame buffer is in use until the previous transfer completes.
+    if (k_sem_take(&tx_sem, K_MSEC(100)) < 0) {
+        LOG_WRN("Previous wired split transfer timed out, aborting it");
+        uart_tx_abort(uart);
+
+        // Overwriting the frame while the UART may still be reading it would send garbage.
+        if (k_sem_take(&tx_sem, K_MSEC(100)) < 0) {
+            LOG_ERR("Wired split transfer could not be aborted, dropping frame");
+            zmk_split_wired_msg_lost();
+            return;
+        }
+    }
+
+    size_t len = encode_frame(item, tx_frame);
+    int err = uart_tx(uart, tx_frame, len, SYS_FOREVER_US);
+    if (err < 0) {
+        LOG_ERR("Failed to send wired split frame (err %d)", err);
+        k_sem_give(&tx_sem);
+    }
+}
+
+static int start_uart(void) {
+    int err = uart_callback_set(uart, uart_callback, NULL);
+    if (err < 0) {
+        LOG_ERR("Failed to set wired split UART callback (err %d)", err);
+        return err;
+    }
+
+    return start_rx();
+}
+
+#elif IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_POLLING)
+
+static void rx_poll_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(rx_poll_work, rx_poll_callback);
+
+static void rx_poll_callback(struct k_work *work) {
+    uint8_t c;
+
+    while (uart_poll_in(uart, &c) == 0) {
+        process_rx_bytes(&c, 1);
+    }
+
+    k_work_schedule_for_queue(&zmk_split_wired_work_q, &rx_poll_work,
+                              K_USEC(CONFIG_ZMK_SPLIT_WIRED_POLLING_RX_PERIOD_US));
+}
+
+static void send_frame(const struct tx_item *item) {
+    uint8_t frame[FRAME_MAX_LEN];
+    size_t len = encode_frame(item, frame);
+
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart, frame[i]);
+    }
+}
+
+static int start_uart(void) {
+    k_work_schedule_for_queue(&zmk_split_wired_work_q, &rx_poll_work, K_NO_WAIT);
+    return 0;
+}
+
+#endif
+
+static void tx_work_callback(struct k_work *work) {
+    struct tx_item item;
+
+    while (k_msgq_get(&wired_tx_msgq, &item, K_NO_WAIT) == 0) {
+        send_frame(&item);
+    }
+}
+
+static K_WORK_DEFINE(tx_work, tx_work_callback);
+
+int zmk_split_wired_send(const struct zmk_split_wired_msg *msg, size_t body_len) {
+    struct tx_item item = {.len = 1 + body_len};
+
+    if (item.len > sizeof(item.msg)) {
+        return -EINVAL;
+    }
+
+    memcpy(&item.msg, msg, item.len);
+
+    int err = k_msgq_put(&wired_tx_msgq, &item, K_NO_WAIT);
+    if (err == -ENOMSG) {
+        LOG_WRN("Wired split message queue full, popping first message and queueing again");
+        struct tx_item discarded_item;
+        k_msgq_get(&wired_tx_msgq, &discarded_item, K_NO_WAIT);
+        err = k_msgq_put(&wired_tx_msgq, &item, K_NO_WAIT);
+        zmk_split_wired_msg_lost();
+    }
+
+    if (err < 0) {
+        LOG_WRN("Failed to queue wired split message to send (%d)", err);
+        return err;
+    }
+
+    k_work_submit_to_queue(&zmk_split_wired_work_q, &tx_work);
+
+    return 0;
+}
+
+static int zmk_split_wired_init(void) {
+    if (!device_is_ready(uart)) {
+        LOG_ERR("Wired split UART device is not ready");
+        return -ENODEV;
+    }
+
+    static const struct k_work_queue_config queue_config = {.name = "Wired Split Queue"};
+    k_work_queue_start(&zmk_split_wired_work_q, wired_q_stack,
+                       K_THREAD_STACK_SIZEOF(wired_q_stack), CONFIG_ZMK_SPLIT_WIRED_PRIORITY,
+                       &queue_config);
+
+    return start_uart();
+}
+
+SYS_INIT(zmk_split_wired_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/matrix.h>
+#include <zmk/sensors.h>
+#include <zmk/events/sensor_event.h>
+
+#define ZMK_SPLIT_WIRED_POS_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+// Behaviors are named after their devices, and Zephyr limits device names to this many bytes
+// including the terminator.
+#define ZMK_SPLIT_WIRED_BEHAVIOR_DEV_LEN Z_DEVICE_MAX_NAME_LEN
+
+enum zmk_split_wired_msg_type {
+    // Peripheral to central
+    ZMK_SPLIT_WIRED_MSG_POSITION_EVENT = 1,
+    ZMK_SPLIT_WIRED_MSG_POSITION_STATE,
+    ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT,
+    ZMK_SPLIT_WIRED_MSG_BATTERY_LEVEL,
+    // Central to peripheral
+    ZMK_SPLIT_WIRED_MSG_RUN_BEHAVIOR,
+    ZMK_SPLIT_WIRED_MSG_HID_INDICATORS,
+    ZMK_SPLIT_WIRED_MSG_POSITION_STATE_REQUEST,
+};
+
+struct zmk_split_wired_position_event {
+    uint16_t position;
+    uint8_t state;
+} __packed;
+
+struct zmk_split_wired_sensor_event {
+    uint8_t sensor_index;
+    uint8_t channel_data_size;
+    struct zmk_sensor_channel_data channel_data[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+} __packed;
+
+// Only the behavior name up to and including its terminator is sent.
+struct zmk_split_wired_run_behavior {
+    uint16_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+    char behavior_dev[ZMK_SPLIT_WIRED_BEHAVIOR_DEV_LEN];
+} __packed;
+
+// Messages are sent as COBS encoded frames with a trailing CRC, delimited by zero bytes. Only the
+// part of the body used by the message type is sent.
+struct zmk_split_wired_msg {
+    uint8_t type;
+    union {
+        struct zmk_split_wired_position_event position_event;
+        uint8_t position_state[ZMK_SPLIT_WIRED_POS_STATE_LEN];
+        struct zmk_split_wired_sensor_event sensor_event;
+        uint8_t battery_level;
+        struct zmk_split_wired_run_behavior run_behavior;
+        uint8_t hid_indicators;
+    } body;
+} __packed;
+
+extern struct k_work_q zmk_split_wired_work_q;
+
+int zmk_split_wired_send(const struct zmk_split_wired_msg *msg, size_t body_len);
+
+// Implemented by the central or peripheral, called from the wired split work queue for every valid
+// message received from the other half. `body_len` is the number of body bytes received.
+void zmk_split_wired_msg_received(const struct zmk_split_wired_msg *msg, size_t body_len);
+
+// Implemented by the central or peripheral, called when a message to or from the other half was
+// dropped, so that the halves can bring their key position state back in sync.
+void zmk_split_wired_msg_lost(void);
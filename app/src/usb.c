@@ -61,6 +61,22 @@ void usb_status_cb(enum usb_dc_status_code status, const uint8_t *params) {
         zmk_usb_hid_set_protocol(HID_PROTOCOL_REPORT);
     }
 #endif
+
+#if IS_ENABLED(CONFIG_ZMK_USB)
+    switch (status) {
+    case USB_DC_RESET:
+    case USB_DC_DISCONNECTED:
+    case USB_DC_SUSPEND:
+    case USB_DC_ERROR:
+        // Queued reports are for a host that is no longer listening, and a write in
+        // flight may never complete.
+        zmk_usb_hid_reset();
+        break;
+    default:
+        break;
+    }
+#endif
+
     usb_status = status;
     k_work_submit(&usb_status_notifier_work);
 };
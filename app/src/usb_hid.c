@@ -12,6 +12,7 @@
 
 #include <zmk/usb.h>
 #include <zmk/hid.h>
+#include <zmk/endpoints.h>
 #include <zmk/keymap.h>
 #if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
 #include <zmk/hid_indicators.h>
@@ -22,9 +23,64 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 static const struct device *hid_dev;
 
+// Held from each write until the endpoint reports it is ready again.
 static K_SEM_DEFINE(hid_sem, 1, 1);
 
-static void in_ready_cb(const struct device *dev) { k_sem_give(&hid_sem); }
+// How long to wait for the endpoint to finish a write before giving up on it.
+#define WRITE_TIMEOUT K_MSEC(30)
+
+// Whether a write is waiting for in_ready_cb(), and how many writes were given up on by
+// write_timeout() but haven't completed yet. The endpoint completes writes in order, so the
+// completions of writes given up on arrive before that of the write in flight, and are ignored
+// rather than releasing hid_sem while it is still busy.
+static bool write_in_flight;
+static int stale_completions;
+static struct k_spinlock write_lock;
+
+static void send_next_report(struct k_work *work);
+
+static K_WORK_DEFINE(send_report_work, send_next_report);
+
+static void write_timeout(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&write_lock);
+    bool timed_out = write_in_flight;
+    if (timed_out) {
+        write_in_flight = false;
+        stale_completions++;
+    }
+    k_spin_unlock(&write_lock, key);
+
+    // in_ready_cb() got there first.
+    if (!timed_out) {
+        return;
+    }
+
+    LOG_WRN("Timed out waiting for the HID endpoint, sending the next report anyway");
+    k_sem_give(&hid_sem);
+    k_work_submit(&send_report_work);
+}
+
+static K_WORK_DELAYABLE_DEFINE(write_timeout_work, write_timeout);
+
+static void in_ready_cb(const struct device *dev) {
+    k_spinlock_key_t key = k_spin_lock(&write_lock);
+    bool completed = false;
+    if (stale_completions > 0) {
+        stale_completions--;
+    } else if (write_in_flight) {
+        write_in_flight = false;
+        completed = true;
+    }
+    k_spin_unlock(&write_lock, key);
+
+    if (!completed) {
+        return;
+    }
+
+    k_work_cancel_delayable(&write_timeout_work);
+    k_sem_give(&hid_sem);
+    k_work_submit(&send_report_work);
+}
 
 #define HID_GET_REPORT_TYPE_MASK 0xff00
 #define HID_GET_REPORT_ID_MASK 0x00ff
@@ -39,6 +95,8 @@ static uint8_t hid_protocol = HID_PROTOCOL_REPORT;
 static void set_proto_cb(const struct device *dev, uint8_t protocol) { hid_protocol = protocol; }
 
 void zmk_usb_hid_set_protocol(uint8_t protocol) { hid_protocol = protocol; }
+
+uint8_t zmk_usb_hid_get_protocol(void) { return hid_protocol; }
 #endif /* IS_ENABLED(CONFIG_ZMK_USB_BOOT) */
 
 static uint8_t *get_keyboard_report(size_t *len) {
@@ -78,6 +136,14 @@ static int get_report_cb(const struct device *dev, struct usb_setup_packet *setu
         *len = sizeof(*report);
         break;
     }
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    case ZMK_HID_REPORT_ID_MOUSE: {
+        struct zmk_hid_mouse_report *report = zmk_hid_get_mouse_report();
+        *data = (uint8_t *)report;
+        *len = sizeof(*report);
+        break;
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
     default:
         LOG_ERR("Invalid report ID %d requested", setup->wValue & HID_GET_REPORT_ID_MASK);
         return -EINVAL;
@@ -126,31 +192,200 @@ static const struct hid_ops ops = {
     .set_report = set_report_cb,
 };
 
-static int zmk_usb_hid_send_report(const uint8_t *report, size_t len) {
+#if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
+#define KEYBOARD_REPORT_MAX_LEN                                                                    \
+    MAX(sizeof(struct zmk_hid_keyboard_report), sizeof(zmk_hid_boot_report_t))
+#else
+#define KEYBOARD_REPORT_MAX_LEN sizeof(struct zmk_hid_keyboard_report)
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+#define MOUSE_REPORT_LEN sizeof(struct zmk_hid_mouse_report)
+#else
+#define MOUSE_REPORT_LEN 0
+#endif
+
+#define REPORT_MAX_LEN                                                                             \
+    MAX(KEYBOARD_REPORT_MAX_LEN, MAX(sizeof(struct zmk_hid_consumer_report), MOUSE_REPORT_LEN))
+
+struct report_buf {
+    uint8_t len;
+    uint8_t data[REPORT_MAX_LEN];
+};
+
+// Reports which change the state of a key or button are sent in the order they
+// were queued, whatever their type, so that edges aren't reordered on the host.
+K_MSGQ_DEFINE(zmk_usb_hid_msgq, sizeof(struct report_buf), CONFIG_ZMK_USB_HID_REPORT_QUEUE_SIZE,
+              1);
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+// Mouse movement without a button change is held here rather than queued, so
+// that further movement can be merged into it. It is only sent when no other
+// report is waiting for the endpoint.
+static struct zmk_hid_mouse_report pending_mouse_report;
+static bool mouse_report_pending = false;
+// The buttons of the last mouse report queued or held as pending.
+static uint8_t queued_mouse_buttons = 0;
+static struct k_spinlock mouse_report_lock;
+
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+static bool is_usb_ready(void) {
     switch (zmk_usb_get_status()) {
     case USB_DC_SUSPEND:
-        return usb_wakeup_request();
     case USB_DC_ERROR:
     case USB_DC_RESET:
     case USB_DC_DISCONNECTED:
     case USB_DC_UNKNOWN:
-        return -ENODEV;
+        return false;
     default:
-        k_sem_take(&hid_sem, K_MSEC(30));
-        int err = hid_int_ep_write(hid_dev, report, len, NULL);
+        return true;
+    }
+}
+
+static int check_usb_status(void) {
+    if (zmk_usb_get_status() == USB_DC_SUSPEND) {
+        return usb_wakeup_request();
+    }
+
+    return is_usb_ready() ? 0 : -ENODEV;
+}
+
+// The endpoints layer records each report as sent once it's queued, so it has to be told when a
+// queued report never reaches the host, or it would skip an identical report sent to replace it.
+static void reports_dropped(void) {
+#if IS_ENABLED(CONFIG_ZMK_ENDPOINTS_SKIP_DUPLICATE_REPORTS)
+    zmk_endpoints_invalidate_sent_reports(
+        (struct zmk_endpoint_instance){.transport = ZMK_TRANSPORT_USB});
+#endif
+}
+
+static int put_report(const void *report, size_t len) {
+    struct report_buf buf = {.len = len};
+    memcpy(buf.data, report, len);
+
+    int err = k_msgq_put(&zmk_usb_hid_msgq, &buf, K_NO_WAIT);
+    if (err == -ENOMSG) {
+        struct report_buf discarded;
+
+        LOG_WRN("Report queue full, dropping the oldest report");
+        k_msgq_get(&zmk_usb_hid_msgq, &discarded, K_NO_WAIT);
+        reports_dropped();
+        err = k_msgq_put(&zmk_usb_hid_msgq, &buf, K_NO_WAIT);
+    }
+
+    return err;
+}
+
+static int queue_report(const void *report, size_t len, const char *name) {
+    int err = put_report(report, len);
+    if (err) {
+        LOG_ERR("Failed to queue %s report (%d)", name, err);
+        return err;
+    }
 
+    k_work_submit(&send_report_work);
+    return 0;
+}
+
+static int get_next_report(uint8_t *buf, size_t *len) {
+    struct report_buf queued;
+    if (k_msgq_get(&zmk_usb_hid_msgq, &queued, K_NO_WAIT) == 0) {
+        memcpy(buf, queued.data, queued.len);
+        *len = queued.len;
+        return 0;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    k_spinlock_key_t key = k_spin_lock(&mouse_report_lock);
+    bool found = mouse_report_pending;
+    if (found) {
+        memcpy(buf, &pending_mouse_report, sizeof(pending_mouse_report));
+        *len = sizeof(pending_mouse_report);
+        mouse_report_pending = false;
+    }
+    k_spin_unlock(&mouse_report_lock, key);
+
+    if (found) {
+        return 0;
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+    return -ENODATA;
+}
+
+void zmk_usb_hid_reset(void) {
+    k_work_cancel_delayable(&write_timeout_work);
+    k_msgq_purge(&zmk_usb_hid_msgq);
+    reports_dropped();
+
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    k_spinlock_key_t key = k_spin_lock(&mouse_report_lock);
+    mouse_report_pending = false;
+    queued_mouse_buttons = 0;
+    k_spin_unlock(&mouse_report_lock, key);
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+    // Any write in flight was aborted, so its completion will never be reported.
+    k_spinlock_key_t write_key = k_spin_lock(&write_lock);
+    write_in_flight = false;
+    stale_completions = 0;
+    k_spin_unlock(&write_lock, write_key);
+
+    k_sem_reset(&hid_sem);
+    k_sem_give(&hid_sem);
+}
+
+static void send_next_report(struct k_work *work) {
+    // in_ready_cb() or write_timeout() resubmits this work once the endpoint is free again.
+    if (k_sem_take(&hid_sem, K_NO_WAIT) != 0) {
+        return;
+    }
+
+    static uint8_t report[REPORT_MAX_LEN];
+    size_t len;
+
+    while (get_next_report(report, &len) == 0) {
+        if (!is_usb_ready()) {
+            // Reports are dropped while the host isn't listening, as before queueing.
+            reports_dropped();
+            continue;
+        }
+
+        // Set before writing, since the endpoint may complete the write before it returns.
+        k_spinlock_key_t key = k_spin_lock(&write_lock);
+        write_in_flight = true;
+        k_spin_unlock(&write_lock, key);
+
+        int err = hid_int_ep_write(hid_dev, report, len, NULL);
         if (err) {
-            k_sem_give(&hid_sem);
+            key = k_spin_lock(&write_lock);
+            write_in_flight = false;
+            k_spin_unlock(&write_lock, key);
+
+            LOG_ERR("Failed to write report (%d)", err);
+            reports_dropped();
+            continue;
         }
 
-        return err;
+        k_work_schedule(&write_timeout_work, WRITE_TIMEOUT);
+        return;
     }
+
+    k_sem_give(&hid_sem);
 }
 
 int zmk_usb_hid_send_keyboard_report(void) {
+    int err = check_usb_status();
+    if (err) {
+        return err;
+    }
+
     size_t len;
     uint8_t *report = get_keyboard_report(&len);
-    return zmk_usb_hid_send_report(report, len);
+
+    return queue_report(report, len, "Keyboard");
 }
 
 int zmk_usb_hid_send_consumer_report(void) {
@@ -160,11 +395,40 @@ int zmk_usb_hid_send_consumer_report(void) {
     }
 #endif /* IS_ENABLED(CONFIG_ZMK_USB_BOOT) */
 
-    struct zmk_hid_consumer_report *report = zmk_hid_get_consumer_report();
-    return zmk_usb_hid_send_report((uint8_t *)report, sizeof(*report));
+    int err = check_usb_status();
+    if (err) {
+        return err;
+    }
+
+    return queue_report(zmk_hid_get_consumer_report(), sizeof(struct zmk_hid_consumer_report),
+                        "Consumer");
 }
 
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+static bool merge_mouse_movement(int8_t *pending, int8_t delta) {
+    int sum = *pending + delta;
+    if (sum < INT8_MIN || sum > INT8_MAX) {
+        return false;
+    }
+
+    *pending = sum;
+    return true;
+}
+
+static bool merge_mouse_report(struct zmk_hid_mouse_report_body *pending,
+                               const struct zmk_hid_mouse_report_body *report) {
+    struct zmk_hid_mouse_report_body merged = *pending;
+    if (!merge_mouse_movement(&merged.d_x, report->d_x) ||
+        !merge_mouse_movement(&merged.d_y, report->d_y) ||
+        !merge_mouse_movement(&merged.d_wheel, report->d_wheel)) {
+        return false;
+    }
+
+    *pending = merged;
+    return true;
+}
+
 int zmk_usb_hid_send_mouse_report() {
 #if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
     if (hid_protocol == HID_PROTOCOL_BOOT) {
@@ -172,8 +436,42 @@ int zmk_usb_hid_send_mouse_report() {
     }
 #endif /* IS_ENABLED(CONFIG_ZMK_USB_BOOT) */
 
+    int err = check_usb_status();
+    if (err) {
+        return err;
+    }
+
     struct zmk_hid_mouse_report *report = zmk_hid_get_mouse_report();
-    return zmk_usb_hid_send_report((uint8_t *)report, sizeof(*report));
+
+    k_spinlock_key_t key = k_spin_lock(&mouse_report_lock);
+    if (report->body.buttons != queued_mouse_buttons) {
+        // A button change is an edge, so it's queued in order with the other reports. Any
+        // pending movement happened before it and has to go out first.
+        if (mouse_report_pending) {
+            err = put_report(&pending_mouse_report, sizeof(pending_mouse_report));
+            mouse_report_pending = false;
+        }
+        if (!err) {
+            err = put_report(report, sizeof(*report));
+        }
+        queued_mouse_buttons = report->body.buttons;
+    } else if (!mouse_report_pending ||
+               !merge_mouse_report(&pending_mouse_report.body, &report->body)) {
+        if (mouse_report_pending) {
+            // The summed movement would overflow, so the pending report goes out as is.
+            err = put_report(&pending_mouse_report, sizeof(pending_mouse_report));
+        }
+        pending_mouse_report = *report;
+        mouse_report_pending = true;
+    }
+    k_spin_unlock(&mouse_report_lock, key);
+
+    if (err) {
+        LOG_ERR("Failed to queue mouse report (%d)", err);
+    }
+
+    k_work_submit(&send_report_work);
+    return err;
 }
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
 